@@ -14,10 +14,27 @@
     }
   ]],
   'targets': [{
+    # Parses and replays the traces in data/, also used by the tests and the
+    # benchmarks.
+    'target_name': 'traceworkload',
+    'type': '<(library)',
+    'dependencies': [
+      'libadblockplus.gyp:libadblockplus'
+    ],
+    'sources': [
+      'shell/src/TraceWorkload.cpp',
+      'shell/src/TraceWorkload.h',
+    ],
+    'direct_dependent_settings': {
+      'include_dirs': ['shell/src'],
+    },
+  },
+  {
     'target_name': 'abpshell',
     'type': 'executable',
     'dependencies': [
-      'libadblockplus.gyp:libadblockplus'
+      'libadblockplus.gyp:libadblockplus',
+      'traceworkload'
     ],
     'sources': [
       'shell/src/Command.cpp',
@@ -31,6 +48,8 @@
       'shell/src/Main.cpp',
       'shell/src/MatchesCommand.cpp',
       'shell/src/MatchesCommand.h',
+      'shell/src/ReplayCommand.cpp',
+      'shell/src/ReplayCommand.h',
       'shell/src/SubscriptionsCommand.cpp',
       'shell/src/SubscriptionsCommand.h',
       'shell/src/WebRequestCurl.cpp',
@@ -19,28 +19,29 @@ jsTemplate = """require.scopes["%s"] = (function() {
 class CStringArray:
     def __init__(self):
         self._buffer = []
-        self._strings = []
+        self._sources = []
 
-    def add(self, string):
+    def add(self, fileName, string):
         string = string.replace('\r', '')
-        self._strings.append('std::string(buffer + %i, %i)' % (len(self._buffer), len(string)))
+        self._sources.append('{%s, buffer + %i, %i}' % (json.dumps(fileName), len(self._buffer), len(string)))
         # Patch for non ASCII characters like in comment in rusha.js which contains '≥'
         self._buffer.extend(map(lambda c: str(ord(c) if 128 > ord(c) else ord(' ')), string))
 
     def write(self, outHandle, arrayName):
-        print('#include <string>', file=outHandle)
+        # The sources stay in read-only data, JsEngine passes them to V8 as
+        # external strings without copying.
+        print('#include "JsSources.h"', file=outHandle)
         print('namespace', file=outHandle)
         print('{', file=outHandle)
-        print('  const char buffer[] = {%s};' % ', '.join(self._buffer), file=outHandle)
+        print('  constexpr char buffer[] = {%s};' % ', '.join(self._buffer), file=outHandle)
         print('}', file=outHandle)
-        print('std::string %s[] = {%s, std::string()};' % (arrayName, ', '.join(self._strings)), file=outHandle)
+        print('constexpr AdblockPlus::JsSource %s[] = {%s};' % (arrayName, ', '.join(self._sources + ['{nullptr, nullptr, 0}'])), file=outHandle)
 
 
 def addFilesVerbatim(array, files):
     for file in files:
         fileHandle = codecs.open(file, 'rb', encoding='utf-8')
-        array.add(os.path.basename(file))
-        array.add(fileHandle.read())
+        array.add(os.path.basename(file), fileHandle.read())
         fileHandle.close()
 
 
@@ -58,8 +59,7 @@ def convertXMLFile(array, file):
             result[name] = value
         data.append(result)
         fileName = os.path.basename(file)
-    array.add(fileName)
-    array.add('require.scopes["%s"] = %s;' % (fileName, json.dumps(data)))
+    array.add(fileName, 'require.scopes["%s"] = %s;' % (fileName, json.dumps(data)))
     fileHandle.close()
 
 
@@ -67,11 +67,10 @@ def convertJsFile(array, file):
     with io.open(file, encoding="utf-8") as jsFile:
       jsFileContent = jsFile.read()
     referenceFileName = os.path.basename(file)
-    array.add(referenceFileName)
     if referenceFileName.endswith('.json'):
-        array.add('require.scopes["../data/%s"] = %s;' % (referenceFileName, jsFileContent))
+        array.add(referenceFileName, 'require.scopes["../data/%s"] = %s;' % (referenceFileName, jsFileContent))
     else:
-        array.add(jsTemplate % (re.sub("\\.jsm?$", "", referenceFileName), jsFileContent))
+        array.add(referenceFileName, jsTemplate % (re.sub("\\.jsm?$", "", referenceFileName), jsFileContent))
 
 
 def convert(verbatimBefore, convertFiles, verbatimAfter, outFile):
@@ -124,6 +124,51 @@ namespace AdblockPlus
      * @param callback The function called on completion.
      */
     virtual void Stat(const std::string& fileName, const StatCallback& callback) const = 0;
+
+    /**
+     * File opened for writing with `OpenWrite()`. Operations complete in the
+     * order they are issued.
+     */
+    class WriteStream
+    {
+    public:
+      virtual ~WriteStream()
+      {
+      }
+
+      /**
+       * Appends data to the file.
+       * @param data The data to write.
+       * @param callback The function called on completion.
+       */
+      virtual void Write(IOBuffer&& data, const Callback& callback) = 0;
+
+      /**
+       * Finishes the file.
+       * @param callback The function called on completion, it also receives
+       *   errors of preceding writes.
+       */
+      virtual void Close(const Callback& callback) = 0;
+    };
+
+    /**
+     * Opens a file for writing it chunk by chunk, previous contents are
+     * replaced. The default implementation collects all chunks and passes
+     * them to `Write()` on close, implementations should override it to keep
+     * memory use independent of the file size.
+     * @param fileName File name.
+     * @return The stream to write to.
+     */
+    virtual std::unique_ptr<WriteStream> OpenWrite(const std::string& fileName);
+
+    /**
+     * Opens a file for appending chunks to it, the file is created if it
+     * doesn't exist. The default implementation collects all chunks and
+     * rewrites the file with `Read()` and `Write()` on close.
+     * @param fileName File name.
+     * @return The stream to write to.
+     */
+    virtual std::unique_ptr<WriteStream> OpenAppend(const std::string& fileName);
   };
 
   /**
@@ -17,13 +17,17 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
+#include <future>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <AdblockPlus/Filter.h>
 #include <AdblockPlus/IElement.h>
+#include <AdblockPlus/IFileSystem.h>
 #include <AdblockPlus/JsValue.h>
 #include <AdblockPlus/Subscription.h>
 
@@ -94,6 +98,35 @@ namespace AdblockPlus
       SUBSCRIPTION_LASTDOWNLOAD,
     };
 
+    /**
+     * Bitmask of `FilterEvent` and `SubscriptionEvent` values, see `ToEventMask()`.
+     */
+    typedef uint32_t EventMask;
+
+    /**
+     * Event mask selecting every filter and subscription event.
+     */
+    static const EventMask ALL_EVENTS = 0xFFFFFFFF;
+
+    /**
+     * Defines how events are delivered to an observer.
+     */
+    enum class EventDelivery
+    {
+      /**
+       * Observer is called on the JavaScript thread while the event is being
+       * processed, one call per event.
+       */
+      SYNCHRONOUS,
+      /**
+       * Events are queued and delivered later from a dedicated thread.
+       * Consecutive events of the same type are delivered together in one
+       * `OnFilterEvents`/`OnSubscriptionEvents` call, events are neither
+       * reordered nor merged.
+       */
+      QUEUED
+    };
+
     /**
      * Observer notified about events applying to filters and subscriptions.
      * @see FilterEvent
@@ -110,6 +143,29 @@ namespace AdblockPlus
       virtual void OnSubscriptionEvent(SubscriptionEvent, const Subscription&)
       {
       }
+
+      /**
+       * Called with a batch of events of the same type when the observer is
+       * registered with `EventDelivery::QUEUED`.
+       * By default calls `OnFilterEvent` for each filter.
+       */
+      virtual void OnFilterEvents(FilterEvent event, const std::vector<Filter>& filters)
+      {
+        for (const auto& filter : filters)
+          OnFilterEvent(event, filter);
+      }
+
+      /**
+       * Called with a batch of events of the same type when the observer is
+       * registered with `EventDelivery::QUEUED`.
+       * By default calls `OnSubscriptionEvent` for each subscription.
+       */
+      virtual void OnSubscriptionEvents(SubscriptionEvent event,
+                                        const std::vector<Subscription>& subscriptions)
+      {
+        for (const auto& subscription : subscriptions)
+          OnSubscriptionEvent(event, subscription);
+      }
     };
 
     /**
@@ -128,6 +184,34 @@ namespace AdblockPlus
       std::string text;
     };
 
+    /**
+     * Arguments of `MatchesAsync()`, see `Matches()` for their meaning.
+     */
+    struct MatchRequest
+    {
+      std::string url;
+      ContentTypeMask contentTypeMask = 0;
+      std::string documentUrl;
+      std::string siteKey;
+      bool specificOnly = false;
+    };
+
+    /**
+     * Callback type invoked with the result of `MatchesAsync()`.
+     */
+    typedef std::function<void(const Filter&)> MatchCallback;
+
+    /**
+     * Frame-level state used to match subresources of a frame, see
+     * CreateFrameContext(). The state is recomputed on next use after
+     * filters or subscriptions have changed.
+     */
+    class FrameContext
+    {
+    public:
+      virtual ~FrameContext() = default;
+    };
+
     virtual ~IFilterEngine() = default;
 
     /**
@@ -165,6 +249,33 @@ namespace AdblockPlus
      */
     virtual std::vector<Subscription> GetListedSubscriptions() const = 0;
 
+    /**
+     * Estimated JavaScript heap retained by the filters of a subscription.
+     */
+    struct SubscriptionMemoryUsage
+    {
+      std::string url;
+      int filterCount;
+      /**
+       * Size of the filter texts, a filter listed in several subscriptions
+       * is split between them.
+       */
+      int64_t textBytes;
+      /**
+       * Filter texts plus an estimate of the parsed filter objects.
+       */
+      int64_t estimatedBytes;
+    };
+
+    /**
+     * Estimates the heap retained by each subscription, including the list
+     * of custom filters, by counting the filters of each list. The estimates
+     * add up to the memory of all filters, it doesn't include the memory of
+     * the engine itself.
+     * @return Memory usage of all subscriptions.
+     */
+    virtual std::vector<SubscriptionMemoryUsage> GetSubscriptionMemoryUsage() const = 0;
+
     /**
      * Retrieves all recommended subscriptions.
      * @return List of recommended subscriptions.
@@ -214,6 +325,25 @@ namespace AdblockPlus
                            const std::string& siteKey = "",
                            bool specificOnly = false) const = 0;
 
+    /**
+     * Asynchronous version of `Matches()` which doesn't block the calling
+     * thread. Requests are handled by a dedicated engine thread, requests for
+     * documents, subdocuments and popups first and images, media and pings
+     * last. Background work like subscription updates yields to pending
+     * requests.
+     * @param request Arguments of the match.
+     * @param callback Called on the engine thread with the matching filter, or
+     *        an invalid filter if there was no match or matching failed.
+     */
+    virtual void MatchesAsync(const MatchRequest& request, const MatchCallback& callback) const = 0;
+
+    /**
+     * Same as `MatchesAsync(const MatchRequest&, const MatchCallback&)` but
+     * returns a future. An exception thrown while matching is passed through
+     * the future, the default implementation reports it as no match.
+     */
+    virtual std::future<Filter> MatchesAsync(const MatchRequest& request) const;
+
     /**
      * Checks whether the resource at the supplied URL is allowlisted.
      * @param url URL of the resource.
@@ -229,6 +359,45 @@ namespace AdblockPlus
                                       const std::vector<std::string>& documentUrls,
                                       const std::string& sitekey = "") const = 0;
 
+    /**
+     * Creates a context for matching subresources of a frame. Hosts of the
+     * frame chain are extracted once and the frame-level allowlisting state
+     * is cached, so requests of the frame don't need to pass and process the
+     * whole chain again.
+     * @param documentUrls Chain of URLs of the frame, starting with the frame
+     *        itself, ending with the top-level frame.
+     * @param sitekey Optional: public key provided by the document.
+     * @return New frame context, it must not outlive the filter engine.
+     */
+    virtual std::unique_ptr<FrameContext>
+    CreateFrameContext(const std::vector<std::string>& documentUrls,
+                       const std::string& sitekey = "") const = 0;
+
+    /**
+     * Checks if any active filter matches a resource requested by a frame.
+     * Unlike `Matches()` it takes GENERICBLOCK and DOCUMENT allowlisting of
+     * the frame into account, like IsContentAllowlisted() would.
+     * @param url URL to match.
+     * @param contentTypeMask Content type mask of the requested resource.
+     * @param frame Context of the frame requesting the resource.
+     * @return Matching filter, or an invalid filter if there was no match.
+     *         If a blocking filter matches but the frame is allowlisted, the
+     *         allowlisting filter is returned instead.
+     */
+    virtual Filter Matches(const std::string& url,
+                           ContentTypeMask contentTypeMask,
+                           const FrameContext& frame) const = 0;
+
+    /**
+     * Checks whether a frame is allowlisted, see IsContentAllowlisted().
+     * Results are cached in the frame context.
+     * @param contentTypeMask Content type mask, e.g. CONTENT_TYPE_ELEMHIDE.
+     * @param frame Context of the frame.
+     * @return `true` iff the frame is allowlisted.
+     */
+    virtual bool IsContentAllowlisted(ContentTypeMask contentTypeMask,
+                                      const FrameContext& frame) const = 0;
+
     /**
      * Retrieves CSS style sheet for all element hiding filters active on the
      * supplied domain.
@@ -253,16 +422,26 @@ namespace AdblockPlus
 
     /**
      * Adds the observer to be notified on various events applying to filters and subscriptions.
+     * Events which are not selected by any registered observer are not
+     * forwarded from JavaScript at all, so narrow masks are cheaper.
      *
      * @param observer Observer to add.
+     * @param mask Events the observer is interested in, see `ToEventMask()`.
+     * @param delivery Whether events are delivered synchronously or queued and
+     *        batched.
      * @see EventObserver
      * @see FilterEvent
      * @see SubscriptionEvent
      */
-    virtual void AddEventObserver(EventObserver* observer) = 0;
+    virtual void AddEventObserver(EventObserver* observer,
+                                  EventMask mask = ALL_EVENTS,
+                                  EventDelivery delivery = EventDelivery::SYNCHRONOUS) = 0;
 
     /**
      * Removes the event observer.
+     * Can be called from the callbacks of a queued observer. A call
+     * which already started on the delivery thread may still be running when
+     * this method returns, no calls start afterwards.
      *
      * @param observer the observer previously added with AddEventObserver()
      */
@@ -282,6 +461,28 @@ namespace AdblockPlus
      */
     virtual std::unique_ptr<std::string> GetAllowedConnectionType() const = 0;
 
+    /**
+     * Preference values by name as stored in prefs.json, e.g.
+     * "allowed_connection_type", see `SetPrefs()`.
+     */
+    struct PrefUpdates
+    {
+      std::map<std::string, bool> booleanPrefs;
+      std::map<std::string, std::string> stringPrefs;
+      std::map<std::string, int64_t> intPrefs;
+    };
+
+    /**
+     * Changes several preferences with a single call into JavaScript.
+     * Preference listeners are notified once all values are changed and
+     * prefs.json is written once, after a short delay which also collects
+     * further changes.
+     * @param prefs New preference values.
+     * @throw JsError if a preference doesn't exist or has a different type,
+     *        no preference is changed then.
+     */
+    virtual void SetPrefs(const PrefUpdates& prefs) = 0;
+
     /**
      * Checks whether the sitekey signature is valid for the given public key and data,
      * where data consists of (uri + "\0" + host + "\0" + userAgent).
@@ -346,6 +547,33 @@ namespace AdblockPlus
      */
     virtual void StopSynchronization() = 0;
 
+    /**
+     * Starts recording calls of `Matches()` and `IsContentAllowlisted()`
+     * with URLs, `GetElementHidingStyleSheet()` and
+     * `GetElementHidingEmulationSelectors()`: their arguments, results and
+     * latencies. Only the most recent calls are kept, previously recorded
+     * calls are dropped.
+     * @param maxCalls Number of calls to keep, 0 stops recording.
+     */
+    virtual void StartTraceRecording(size_t maxCalls) = 0;
+
+    /**
+     * Stops recording calls, the recorded calls are kept until they are
+     * flushed.
+     */
+    virtual void StopTraceRecording() = 0;
+
+    /**
+     * Appends the recorded calls to a file as JSON lines, as in the
+     * data/rec_*.log traces, and removes them from memory. The file can be
+     * replayed by test/HarnessTest.cpp.
+     * @param fileName File to append to, written through `IFileSystem`.
+     * @param callback Called once the calls are written, receives an error
+     *        message if writing failed.
+     */
+    virtual void FlushTraceRecording(const std::string& fileName,
+                                     const IFileSystem::Callback& callback) = 0;
+
     /**
      * Compile script to inject as content script. It is executed in tab context on behalf
      * of web extension. Can be empty if no rule require injection of such script.
@@ -357,6 +585,32 @@ namespace AdblockPlus
     virtual std::string GetSnippetScript(const std::string& documentUrl,
                                          const std::string& librarySource) = 0;
 
+    /**
+     * Sets the snippet library used by `GetSnippetScript(const std::string&)`.
+     * The library is passed to the JavaScript engine only once and compiled
+     * scripts are cached per host until filters or subscriptions change.
+     * @param librarySource snippet library source, see `GetSnippetScript()`.
+     */
+    virtual void SetSnippetLibrary(const std::string& librarySource) = 0;
+
+    /**
+     * Compile script to inject as content script using the library set by
+     * `SetSnippetLibrary()`. Results are cached per host of `documentUrl`.
+     * @param documentUrl url of the tab
+     * @return Script to inject, empty if no rule requires injection or no
+     * library has been set.
+     */
+    virtual std::string GetSnippetScript(const std::string& documentUrl) = 0;
+
+    //@{
+    /**
+     * Returns the bit of `EventMask` corresponding to the event.
+     * Masks can be combined using bitwise OR.
+     */
+    static EventMask ToEventMask(FilterEvent event);
+    static EventMask ToEventMask(SubscriptionEvent event);
+    //@}
+
     /**
      * Retrieves the `ContentType` for the supplied string.
      * @param contentType Content type string.
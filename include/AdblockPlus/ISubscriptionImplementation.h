@@ -116,6 +116,18 @@ namespace AdblockPlus
      */
     virtual int GetVersion() const = 0;
 
+    /**
+     * Number of filters the last update of the subscription added.
+     * @return number of new filters or zero if there were no updates.
+     */
+    virtual int GetLastUpdateAddedCount() const = 0;
+
+    /**
+     * Number of filters the last update of the subscription removed.
+     * @return number of dropped filters or zero if there were no updates.
+     */
+    virtual int GetLastUpdateRemovedCount() const = 0;
+
     virtual bool operator==(const ISubscriptionImplementation& other) const = 0;
 
     virtual std::unique_ptr<ISubscriptionImplementation> Clone() const = 0;
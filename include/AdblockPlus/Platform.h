@@ -31,6 +31,7 @@
 #include <AdblockPlus/ITimer.h>
 #include <AdblockPlus/IWebRequest.h>
 #include <AdblockPlus/LogSystem.h>
+#include <AdblockPlus/StartupTimeline.h>
 
 namespace AdblockPlus
 {
@@ -90,5 +91,20 @@ namespace AdblockPlus
     virtual IWebRequest& GetWebRequest() const = 0;
     virtual LogSystem& GetLogSystem() const = 0;
     virtual IResourceReader& GetResourceReader() const = 0;
+
+    /**
+     * Retrieves the time taken by the startup phases reached so far: V8
+     * initialization if this was the first engine of the process,
+     * `JsEngine` creation, evaluation of each script
+     * ("evaluate:<file>"), "initializePrefs", loading of the filter storage
+     * ("filterEngine.initialize"), the first "_init" event which finishes the
+     * `IFilterEngine` creation and the "first Matches" call.
+     * Phases are timed relative to the start of `SetUp()`, the timeline is
+     * empty before it. The default implementation reports no phases.
+     */
+    virtual StartupTimeline GetStartupTimeline() const
+    {
+      return StartupTimeline();
+    }
   };
 }
@@ -32,6 +32,10 @@ namespace AdblockPlus
      */
     struct CreationParameters
     {
+      CreationParameters() : compressFilterStorage(false)
+      {
+      }
+
       LogSystemPtr logSystem;
       TimerPtr timer;
       WebRequestPtr webRequest;
@@ -46,6 +50,12 @@ namespace AdblockPlus
        * subsystems is not provided.
        */
       std::unique_ptr<IExecutor> executor;
+      /**
+       * Store patterns.ini and its backups compressed, this applies to a
+       * provided fileSystem as well. Files written uncompressed before are
+       * still read.
+       */
+      bool compressFilterStorage;
     };
 
     /**
@@ -17,9 +17,10 @@
 
 #pragma once
 
-#include <list>
-#include <map>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace AdblockPlus
@@ -29,6 +30,9 @@ namespace AdblockPlus
    * This can be used to build a chain of referrers for any URL
    * (see `BuildReferrerChain()`), which approximates the frame structure, see
    * IFilterEngine::Matches().
+   * Both `Add()` and `BuildReferrerChain()` take constant time, chains are
+   * memoized per referrer. `BuildReferrerChain()` may be called concurrently,
+   * `Add()` must not run concurrently with any other call.
    */
   class ReferrerMapping
   {
@@ -40,6 +44,8 @@ namespace AdblockPlus
      *        request will break the referrer chain.
      */
     ReferrerMapping(const int maxCachedUrls = 5000);
+    ReferrerMapping(const ReferrerMapping&) = delete;
+    ReferrerMapping& operator=(const ReferrerMapping&) = delete;
 
     /**
      * Records the refferer for a URL.
@@ -57,8 +63,41 @@ namespace AdblockPlus
     std::vector<std::string> BuildReferrerChain(const std::string& url) const;
 
   private:
+    /**
+     * Each URL, either recorded or only known as a referrer, is stored once.
+     */
+    struct Entry
+    {
+      // Points to the key of this entry.
+      const std::string* url = nullptr;
+      // nullptr if the URL has not been recorded by Add().
+      Entry* referrer = nullptr;
+      // Number of recorded URLs having this entry as referrer.
+      int referencedBy = 0;
+      // Intrusive least recently used list of recorded URLs.
+      Entry* newer = nullptr;
+      Entry* older = nullptr;
+      // Chain ending with this URL, valid if cachedGeneration == generation.
+      // Guarded by chainCacheMutex.
+      mutable std::vector<std::string> cachedChain;
+      mutable uint64_t cachedGeneration = 0;
+    };
+    typedef std::unordered_map<std::string, Entry> Entries;
+
+    Entry& Intern(const std::string& url);
+    void ReleaseIfUnused(Entry& entry);
+    void Unlink(Entry& entry);
+    void Unmap(Entry& entry);
+    const std::vector<std::string>& GetChain(const Entry& entry) const;
+
     const int maxCachedUrls;
-    std::map<std::string, std::string> mapping;
-    std::list<std::string> cachedUrls;
+    Entries entries;
+    int cachedUrlCount;
+    Entry* newest;
+    Entry* oldest;
+    // Incremented whenever an existing chain may have changed.
+    uint64_t generation;
+    // Memoizing chains is the only side effect of const methods.
+    mutable std::mutex chainCacheMutex;
   };
 }
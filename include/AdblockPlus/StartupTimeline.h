@@ -0,0 +1,51 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace AdblockPlus
+{
+  /**
+   * Phase of the startup of a platform, see `Platform::GetStartupTimeline()`.
+   */
+  struct StartupPhase
+  {
+    /**
+     * Name of the phase, e.g. "JsEngine::New" or "evaluate:init.js".
+     */
+    std::string name;
+
+    /**
+     * Time from the start of `Platform::SetUp()` until the phase started.
+     */
+    std::chrono::microseconds start;
+
+    /**
+     * Time the phase took.
+     */
+    std::chrono::microseconds duration;
+  };
+
+  /**
+   * Startup phases ordered by the time they ended.
+   */
+  typedef std::vector<StartupPhase> StartupTimeline;
+}
@@ -45,6 +45,8 @@ namespace AdblockPlus
     int GetLastDownloadAttemptTime() const;
     int GetLastDownloadSuccessTime() const;
     int GetVersion() const;
+    int GetLastUpdateAddedCount() const;
+    int GetLastUpdateRemovedCount() const;
     bool operator==(const Subscription& other) const;
     const ISubscriptionImplementation* Implementation() const;
     Subscription& operator=(const Subscription& filter);
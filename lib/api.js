@@ -19,7 +19,7 @@
 
 let API = (() =>
 {
-  const {Filter} = require("filterClasses");
+  const {Filter, AllowingFilter} = require("filterClasses");
   const {Subscription} = require("subscriptionClasses");
   const {SpecialSubscription, DownloadableSubscription} = require("subscriptionClasses");
   const {filterStorage} = require("filterStorage");
@@ -27,13 +27,101 @@ let API = (() =>
   const {elemHide} = require("elemHide");
   const {elemHideEmulation} = require("elemHideEmulation");
   const {synchronizer} = require("synchronizer");
-  const {Prefs} = require("prefs");
-  const {visibleRecommendations} = require("recommendations");
-  const SignatureVerifier = require("rsa");
+  const {Prefs, setPrefs, flushPrefs} = require("prefs");
   const {parseURL} = require("url");
-  const {composeFilterSuggestions} = require("compose");
   const {registerSubscription} = require("init");
-  const {snippets, compileScript} = require("snippets");
+  const {filterNotifier} = require("filterNotifier");
+  const {getLastUpdateDelta} = require("filterUpdateRegistration");
+
+  // Rough V8 footprint of a filter besides its text: the filter object and
+  // its entries in Filter.knownFilters and the matcher maps. Compare with the
+  // bytes per filter reported by test/MemoryBenchmark.cpp when tuning.
+  const estimatedFilterOverhead = 200;
+
+  // Maximum number of hosts for which compiled snippet scripts are kept.
+  const maxCachedSnippetScripts = 100;
+
+  let snippetLibrary = null;
+  // Maps hosts to compiled scripts, iteration order is the order of use.
+  let snippetScriptCache = new Map();
+
+  // Incremented whenever the set of active filters may have changed, results
+  // cached in frame contexts are only valid for the same generation.
+  let filtersGeneration = 0;
+
+  // Active filters can only change with these events.
+  for (let event of ["load",
+                     "filter.added",
+                     "filter.disabled",
+                     "filter.removed",
+                     "subscription.added",
+                     "subscription.disabled",
+                     "subscription.removed",
+                     "subscription.updated"])
+  {
+    filterNotifier.on(event, () =>
+    {
+      filtersGeneration++;
+      snippetScriptCache.clear();
+    });
+  }
+
+  class FrameContext
+  {
+    constructor(documentUrls, siteKey, documentMask, genericBlockMask)
+    {
+      this.documentHost = extractHostFromURL(documentUrls[0] || "");
+      this.siteKey = siteKey;
+      this.documentMask = documentMask >>> 0;
+      this.genericBlockMask = genericBlockMask >>> 0;
+      // Each frame of the chain is matched against its parent's host, the
+      // top-level frame against its own host.
+      this.frames = documentUrls.map((url, i) => ({
+        urlInfo: url ? getURLInfo(url) : null,
+        parentHost: extractHostFromURL(documentUrls[i + 1] || url)
+      }));
+      this.generation = filtersGeneration;
+      this.allowlistingFilters = new Map();
+    }
+
+    getAllowlistingFilter(contentTypeMask)
+    {
+      if (this.generation != filtersGeneration)
+      {
+        this.generation = filtersGeneration;
+        this.allowlistingFilters.clear();
+      }
+
+      let filter = this.allowlistingFilters.get(contentTypeMask);
+      if (typeof filter == "undefined")
+      {
+        filter = null;
+        for (let {urlInfo, parentHost} of this.frames)
+        {
+          if (urlInfo)
+          {
+            filter = defaultMatcher.match(urlInfo, contentTypeMask, parentHost,
+                                          this.siteKey, false);
+          }
+          if (filter)
+            break;
+        }
+        this.allowlistingFilters.set(contentTypeMask, filter);
+      }
+      return filter;
+    }
+  }
+
+  function compileSnippetsScript(documentHost, library)
+  {
+    const {snippets, compileScript} = require("snippets");
+    let scripts = snippets.getFilters(documentHost).map(it => it.script);
+
+    if (!scripts.length)
+      return "";
+
+    return compileScript(scripts, [library], {});
+  }
 
   function getURLInfo(url)
   {
@@ -128,6 +216,16 @@ let API = (() =>
       return synchronizer.isExecuting(subscription.url);
     },
 
+    getLastUpdateAddedCount(subscription)
+    {
+      return getLastUpdateDelta(subscription).added;
+    },
+
+    getLastUpdateRemovedCount(subscription)
+    {
+      return getLastUpdateDelta(subscription).removed;
+    },
+
     getListedSubscriptions()
     {
       let subscriptions = [];
@@ -139,8 +237,43 @@ let API = (() =>
       return subscriptions;
     },
 
+    getSubscriptionMemoryUsage()
+    {
+      // Filters listed in several subscriptions are split between them, so
+      // that the estimates add up to the memory of all filters.
+      let owners = new Map();
+      for (let subscription of filterStorage.subscriptions())
+      {
+        for (let text of subscription.filterText())
+          owners.set(text, (owners.get(text) || 0) + 1);
+      }
+
+      let result = [];
+      for (let subscription of filterStorage.subscriptions())
+      {
+        let textBytes = 0;
+        let estimatedBytes = 0;
+        for (let text of subscription.filterText())
+        {
+          // V8 stores Latin-1 strings with one byte per character.
+          let size = /[^\x00-\xff]/.test(text) ? text.length * 2 : text.length;
+          let count = owners.get(text);
+          textBytes += size / count;
+          estimatedBytes += (size + estimatedFilterOverhead) / count;
+        }
+        result.push({
+          url: subscription.url,
+          filterCount: subscription.filterCount,
+          textBytes: Math.round(textBytes),
+          estimatedBytes: Math.round(estimatedBytes)
+        });
+      }
+      return result;
+    },
+
     getRecommendedSubscriptions()
     {
+      const {visibleRecommendations} = require("recommendations");
       let result = [];
       for (let {url, title, homepage, languages} of visibleRecommendations())
       {
@@ -217,6 +350,37 @@ let API = (() =>
                                   siteKey, specificOnly);
     },
 
+    createFrameContext(documentUrls, siteKey, documentMask, genericBlockMask)
+    {
+      return new FrameContext(documentUrls, siteKey, documentMask,
+                              genericBlockMask);
+    },
+
+    checkFilterMatchInFrame(url, contentTypeMask, frame)
+    {
+      let urlInfo = getURLInfo(url);
+      if (!urlInfo)
+        return null;
+
+      let specificOnly = frame.frames.length > 0 &&
+        !!frame.getAllowlistingFilter(frame.genericBlockMask);
+      let filter = defaultMatcher.match(urlInfo, contentTypeMask >>> 0,
+                                        frame.documentHost, frame.siteKey,
+                                        specificOnly);
+      if (filter && !(filter instanceof AllowingFilter))
+      {
+        let allowlistingFilter = frame.getAllowlistingFilter(frame.documentMask);
+        if (allowlistingFilter)
+          return allowlistingFilter;
+      }
+      return filter;
+    },
+
+    isFrameAllowlisted(contentTypeMask, frame)
+    {
+      return !!frame.getAllowlistingFilter(contentTypeMask >>> 0);
+    },
+
     getElementHidingStyleSheet(url, specificOnly)
     {
       let host = url.indexOf(':') != -1 ? extractHostFromURL(url) : url;
@@ -239,13 +403,25 @@ let API = (() =>
       Prefs[pref] = value;
     },
 
+    setPrefs(prefs)
+    {
+      setPrefs(prefs);
+    },
+
+    flushPrefs()
+    {
+      flushPrefs();
+    },
+
     verifySignature(key, signature, uri, host, userAgent)
     {
+      const SignatureVerifier = require("rsa");
       return SignatureVerifier.verifySignature(key, signature, uri + "\0" + host + "\0" + userAgent);
     },
 
     composeFilterSuggestions(baseUrl, tagName, id, src, style, classes, relatedUrls)
     {
+      const {composeFilterSuggestions} = require("compose");
       return composeFilterSuggestions(baseUrl, tagName, id, src, style, classes, relatedUrls);
     },
 
@@ -261,15 +437,36 @@ let API = (() =>
       Prefs.synchronization_enabled = false;
     },
 
-    getSnippetsScript(documentUrl, snippetLibrary)
+    getSnippetsScript(documentUrl, library)
     {
-      let documentHost = extractHostFromURL(documentUrl);
-      let scripts = snippets.getFilters(documentHost).map(it => it.script);
+      return compileSnippetsScript(extractHostFromURL(documentUrl), library);
+    },
 
-      if (!scripts.length)
+    setSnippetLibrary(library)
+    {
+      snippetLibrary = library;
+      snippetScriptCache.clear();
+    },
+
+    getCachedSnippetsScript(documentUrl)
+    {
+      if (snippetLibrary == null)
         return "";
 
-      return compileScript(scripts, [snippetLibrary], {});
+      let documentHost = extractHostFromURL(documentUrl);
+      let script = snippetScriptCache.get(documentHost);
+      if (typeof script == "undefined")
+      {
+        script = compileSnippetsScript(documentHost, snippetLibrary);
+        if (snippetScriptCache.size >= maxCachedSnippetScripts)
+          snippetScriptCache.delete(snippetScriptCache.keys().next().value);
+      }
+      else
+      {
+        snippetScriptCache.delete(documentHost);
+      }
+      snippetScriptCache.set(documentHost, script);
+      return script;
     },
   };
 })();
@@ -29,6 +29,9 @@ function require(module)
   // https://issues.adblockplus.org/ticket/5762
   if (module.startsWith("./"))
     module = module.substring(2);
+  // Rarely used modules are only evaluated the first time they are required.
+  if (!(module in require.scopes))
+    _triggerEvent("_requireModule", module);
   return require.scopes[module];
 }
 require.scopes = {__proto__: null};
@@ -56,6 +59,7 @@ XMLHttpRequest.prototype =
   status: 0,
   readyState: 0,
   responseText: null,
+  _checksumMismatch: false,
 
   // list taken from https://developer.mozilla.org/en-US/docs/Glossary/Forbidden_header_name
   _forbiddenRequestHeaders: new Set([
@@ -169,6 +173,7 @@ XMLHttpRequest.prototype =
     {
       this.status = result.responseStatus;
       this.responseText = result.responseText;
+      this._checksumMismatch = !!result.checksumMismatch;
       this._responseHeaders = result.responseHeaders;
       this.readyState = 4;
 
@@ -291,7 +296,7 @@ function fetch(url, initObj)
 
     let handleLoad = () =>
     {
-      let {status, responseText} = request;
+      let {status, responseText, _checksumMismatch: checksumMismatch} = request;
       let responseHeaders = request.getAllResponseHeaders();
 
       for (const header in responseHeaders) {
@@ -302,7 +307,12 @@ function fetch(url, initObj)
 
       let response = {
         status,
-        text: () => Promise.resolve(responseText),
+        text()
+        {
+          if (checksumMismatch)
+            return Promise.reject(new Error("Filter list checksum mismatch"));
+          return Promise.resolve(responseText);
+        },
         headers
       };
 
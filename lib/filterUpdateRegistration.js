@@ -18,6 +18,7 @@
 "use strict";
 
 const {filterNotifier} = require("filterNotifier");
+const {filterStorage} = require("filterStorage");
 
 let events = [
   "elemhideupdate",
@@ -43,7 +44,106 @@ let events = [
   "subscription.updated",
 ];
 
-// Until we change libadblockplus API we need to listen to all the
-// notification.
+// While a downloaded list replaces the filters of a subscription core reports
+// every single added and removed filter, which for big lists means tens of
+// thousands of round trips into C++. Those notifications are held back during
+// the update and summarized by a single subscription.updated event instead.
+let applyingUpdate = 0;
+
+// Maps subscriptions to the number of filters added and removed by their last
+// update as {added, removed}, see getLastUpdateDelta().
+let lastUpdateDeltas = new WeakMap();
+
+// Filter notifications held back during the current update, only used if
+// core doesn't report the delta.
+let heldBackCounts = null;
+
+function isSummarizedEvent(event)
+{
+  return event == "filter.added" || event == "filter.removed" ||
+         event == "subscription.updated";
+}
+
+// Core computes the delta anyway to update the matcher incrementally and
+// passes it along with its subscription.updated notification.
+filterNotifier.on("subscription.updated", (subscription, textDelta) =>
+{
+  if (textDelta)
+  {
+    lastUpdateDeltas.set(subscription, {
+      added: textDelta.added.length,
+      removed: textDelta.removed.length
+    });
+  }
+});
+
+for (let event of ["filter.added", "filter.removed"])
+{
+  let key = event == "filter.added" ? "added" : "removed";
+  filterNotifier.on(event, () =>
+  {
+    if (heldBackCounts)
+      heldBackCounts[key]++;
+  });
+}
+
+let updateSubscriptionFilters = filterStorage.updateSubscriptionFilters;
+filterStorage.updateSubscriptionFilters = function(subscription, filterText)
+{
+  lastUpdateDeltas.delete(subscription);
+  let counts = {added: 0, removed: 0};
+  let outerCounts = heldBackCounts;
+  heldBackCounts = counts;
+  applyingUpdate++;
+  try
+  {
+    updateSubscriptionFilters.call(this, subscription, filterText);
+  }
+  finally
+  {
+    applyingUpdate--;
+    heldBackCounts = outerCounts;
+  }
+
+  // Without a delta from core the held back notifications are counted
+  // instead. If there were none either, the update is reported anyway, as
+  // it can't be told whether the list changed.
+  let delta = lastUpdateDeltas.get(subscription);
+  if (!delta)
+  {
+    lastUpdateDeltas.set(subscription, counts);
+    if (counts.added == 0 && counts.removed == 0)
+      console.warn("No filter delta reported for the update of " + subscription.url);
+  }
+  else if (delta.added == 0 && delta.removed == 0)
+  {
+    // Nothing to report if the downloaded list didn't change.
+    return;
+  }
+
+  if (_observedEvents["subscription.updated"])
+    _triggerEvent("filterChange", "subscription.updated", subscription);
+};
+
+// Returns the number of filters added to and removed from the subscription by
+// its last update as {added, removed}.
+function getLastUpdateDelta(subscription)
+{
+  return lastUpdateDeltas.get(subscription) || {added: 0, removed: 0};
+}
+
+exports.getLastUpdateDelta = getLastUpdateDelta;
+
+// _observedEvents is maintained by DefaultFilterEngine and contains only the
+// events some IFilterEngine::EventObserver is registered for. Skipping the
+// rest avoids crossing into C++ for e.g. frequent filter.hitCount updates.
 for (let event of events)
-  filterNotifier.on(event, item => _triggerEvent("filterChange", event, item));
+{
+  filterNotifier.on(event, item =>
+  {
+    if (applyingUpdate && isSummarizedEvent(event))
+      return;
+    if (_observedEvents[event])
+      _triggerEvent("filterChange", event, item);
+  });
+}
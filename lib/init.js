@@ -19,9 +19,10 @@
 
 const {Prefs, initializePrefs} = require("prefs");
 const {filterEngine} = require("filterEngine");
-const {visibleRecommendations} = require("recommendations");
 const {synchronizer, addSubscriptionFilters} = require("synchronizer");
 const {filterStorage} = require("filterStorage");
+const {filterNotifier} = require("filterNotifier");
+const {IO} = require("io");
 const {Subscription} = require("subscriptionClasses");
 const {Utils} = require("utils");
 const {MILLIS_IN_SECOND, MILLIS_IN_HOUR, MILLIS_IN_DAY} = require("time");
@@ -157,6 +158,7 @@ async function startEngine()
 {
   if (Prefs.first_run && Prefs.first_run_subscription_auto_select)
   {
+    const {visibleRecommendations} = require("recommendations");
     let node = Utils.chooseFilterSubscription([...visibleRecommendations()]);
     if (node)
     {
@@ -186,6 +188,26 @@ async function startEngine()
     Prefs.first_run = false;
 }
 
+// IO.writeToFile() drops a complete rewrite of patterns.ini if the storage
+// changed while it was written.
+for (let event of ["filter.added",
+                   "filter.moved",
+                   "filter.removed",
+                   "subscription.added",
+                   "subscription.removed",
+                   "subscription.updated"])
+{
+  filterNotifier.on(event, () => IO.notifyStorageChange());
+}
+
+// Reported to Platform::GetStartupTimeline().
+async function measureStartupPhase(name, phase)
+{
+  _triggerEvent("_startupPhase", name, false);
+  await phase();
+  _triggerEvent("_startupPhase", name, true);
+}
+
 async function initializeEngine()
 {
   // This is a workaround due to the issue adblockpluscore#285. Please
@@ -194,8 +216,8 @@ async function initializeEngine()
     synchronizer._downloader._download(downloadable, 0);
   };
 
-  await initializePrefs();
-  await filterEngine.initialize();
+  await measureStartupPhase("initializePrefs", initializePrefs);
+  await measureStartupPhase("filterEngine.initialize", () => filterEngine.initialize());
   await startEngine();
 
   _triggerEvent("_init");
@@ -17,6 +17,35 @@
 
 "use strict";
 
+// Number of characters collected from the generator before they are handed
+// to the file system by IO.writeToFile().
+const WRITE_CHUNK_SIZE = 64 * 1024;
+
+// Files written by IO.writeToFile(), i.e. patterns.ini, are saved
+// incrementally. The file is split into sections starting with a "[...]"
+// line and only the sections which changed since the last save are appended
+// to a journal next to the file. The complete file is rewritten once the
+// journal gets large compared to it, IO.readFromFile() replays the journal.
+const JOURNAL_SUFFIX = ".journal";
+const MIN_JOURNAL_SIZE_LIMIT = 16 * 1024;
+const JOURNAL_SIZE_LIMIT_RATIO = 0.25;
+
+// While the complete file is rewritten the journal is renamed to the stale
+// journal and the new file is written to the temporary file, see
+// writeCompleteFile().
+const STALE_JOURNAL_SUFFIX = ".journal.old";
+const TEMP_SUFFIX = ".tmp";
+
+// Files saved or loaded so far, maps file names to the keys and lines of
+// their sections and the sizes of the file and its journal. The lines are
+// mostly the strings core keeps anyway, e.g. the filter texts, so comparing
+// them on the next save is cheap and keeping them costs little memory.
+let journalStates = new Map();
+
+// Incremented by IO.notifyStorageChange() whenever filters or subscriptions
+// are added, removed, moved or updated, see writeCompleteFile().
+let storageChanges = 0;
+
 function readFileAsync(fileName)
 {
   return new Promise((resolve, reject) =>
@@ -25,6 +54,14 @@ function readFileAsync(fileName)
   });
 }
 
+function readLinesAsync(fileName, listener)
+{
+  return new Promise((resolve, reject) =>
+  {
+    _fileSystem.readFromFile(fileName, listener, resolve, reject);
+  });
+}
+
 function writeFileAsync(fileName, content)
 {
   return new Promise((resolve, reject) =>
@@ -38,28 +75,597 @@ function writeFileAsync(fileName, content)
   });
 }
 
+function moveFileAsync(fromFileName, toFileName)
+{
+  return new Promise((resolve, reject) =>
+  {
+    _fileSystem.move(fromFileName, toFileName, (error) =>
+    {
+      if (error)
+        return reject(error);
+      resolve();
+    });
+  });
+}
+
+function fileExistsAsync(fileName)
+{
+  return new Promise((resolve, reject) =>
+  {
+    _fileSystem.stat(fileName, (result) =>
+    {
+      if (result.error)
+        return reject(result.error);
+      resolve(result.exists);
+    });
+  });
+}
+
+function removeFileIgnoringErrors(fileName)
+{
+  return new Promise(resolve =>
+  {
+    _fileSystem.remove(fileName, () => resolve());
+  });
+}
+
+// Writes the chunks returned by nextChunk() to a file opened with
+// _fileSystem.openWrite() or _fileSystem.openAppend() until it returns an
+// empty string. The next chunk is only requested once the previous one is
+// written.
+function writeChunks(file, nextChunk)
+{
+  return new Promise((resolve, reject) =>
+  {
+    let close = error =>
+    {
+      _fileSystem.close(file, closeError =>
+      {
+        error = error || closeError;
+        if (error)
+          return reject(error);
+        resolve();
+      });
+    };
+
+    let writeChunk = () =>
+    {
+      let chunk;
+      try
+      {
+        chunk = nextChunk();
+      }
+      catch (error)
+      {
+        close(error);
+        return;
+      }
+
+      if (!chunk)
+      {
+        close();
+        return;
+      }
+
+      _fileSystem.writeChunk(file, chunk, error =>
+      {
+        if (error)
+          return close(error);
+        writeChunk();
+      });
+    };
+    writeChunk();
+  });
+}
+
+function journalFileName(fileName)
+{
+  return fileName + JOURNAL_SUFFIX;
+}
+
+function staleJournalFileName(fileName)
+{
+  return fileName + STALE_JOURNAL_SUFFIX;
+}
+
+// The extension is kept, so that file systems which treat files by their
+// name, like CompressingFileSystem, handle it like the file itself.
+function tempFileName(fileName)
+{
+  let [, name, extension] = /^(.*?)(\.[^./\\]*)?$/.exec(fileName);
+  return name + TEMP_SUFFIX + (extension || "");
+}
+
+function createJournalState()
+{
+  return {
+    keys: [],
+    sections: new Map(),
+    baseSize: 0,
+    journalSize: 0,
+    // Set if the journal may contain more than the replayed batches, e.g.
+    // the remains of an interrupted write. Nothing can be appended to it
+    // then, the next save rewrites the complete file.
+    needsCompaction: false
+  };
+}
+
+// Splits lines into sections, calls onSection() with a key identifying each
+// section and its lines.
+class SectionSplitter
+{
+  constructor(onSection)
+  {
+    this._onSection = onSection;
+    this._keys = new Set();
+    this._subscriptionKey = "";
+    this._startSection("");
+  }
+
+  push(line)
+  {
+    if (line.includes("\n"))
+    {
+      for (let part of line.split("\n"))
+        this.push(part);
+      return;
+    }
+    // Empty lines are skipped by IO.readFromFile() anyway.
+    if (!line)
+      return;
+
+    if (line[0] == "[" && line[line.length - 1] == "]")
+    {
+      this._finishSection();
+      this._startSection(line);
+    }
+    else if (this._firstLine == null)
+      this._firstLine = line;
+    this._lines.push(line);
+  }
+
+  finish()
+  {
+    this._finishSection();
+  }
+
+  _startSection(header)
+  {
+    this._header = header;
+    this._firstLine = null;
+    this._lines = [];
+  }
+
+  _finishSection()
+  {
+    if (!this._lines.length)
+      return;
+
+    // Subscriptions and filters are identified by their first property, the
+    // filters of a subscription follow it.
+    let key = this._header + "\n" + (this._firstLine || "");
+    if (this._header == "[Subscription filters]")
+      key = this._subscriptionKey + "\n" + this._header;
+    else if (this._header == "[Subscription]")
+      this._subscriptionKey = key;
+
+    let uniqueKey = key;
+    for (let i = 1; this._keys.has(uniqueKey); i++)
+      uniqueKey = key + "\n" + i;
+    this._keys.add(uniqueKey);
+
+    this._onSection(uniqueKey, this._lines);
+  }
+}
+
+function trackSections(state)
+{
+  return new SectionSplitter((key, lines) =>
+  {
+    state.keys.push(key);
+    state.sections.set(key, lines);
+  });
+}
+
+function sameLines(lines, otherLines)
+{
+  if (!lines || lines.length != otherLines.length)
+    return false;
+  for (let i = 0; i < lines.length; i++)
+  {
+    if (lines[i] !== otherLines[i])
+      return false;
+  }
+  return true;
+}
+
+// Order of the sections of a file, `null` stands for the beginning.
+class SectionOrder
+{
+  constructor(keys)
+  {
+    this._next = new Map([[null, null]]);
+    this._previous = new Map();
+    let last = null;
+    for (let key of keys)
+    {
+      this.insertAfter(key, last);
+      last = key;
+    }
+  }
+
+  previous(key)
+  {
+    return this._previous.get(key);
+  }
+
+  remove(key)
+  {
+    if (!this._previous.has(key))
+      return;
+
+    let previous = this._previous.get(key);
+    let next = this._next.get(key);
+    this._next.set(previous, next);
+    if (next !== null)
+      this._previous.set(next, previous);
+    this._previous.delete(key);
+    this._next.delete(key);
+  }
+
+  insertAfter(key, after)
+  {
+    this.remove(key);
+    if (!this._next.has(after))
+      after = null;
+
+    let next = this._next.get(after);
+    this._next.set(after, key);
+    this._previous.set(key, after);
+    this._next.set(key, next);
+    if (next !== null)
+      this._previous.set(next, key);
+  }
+
+  *keys()
+  {
+    for (let key = this._next.get(null); key !== null; key = this._next.get(key))
+      yield key;
+  }
+}
+
+// Applies the journal to the sections of the file. Each save appends a batch
+// of records terminated by an "end" record holding the length of the batch.
+// Replaying stops at the first batch which is incomplete or doesn't have the
+// recorded length, e.g. because a write was interrupted. Returns the length
+// of the replayed part of the journal, including the line break after it.
+function replayJournal(journal, sections, order)
+{
+  let lines = journal.split("\n");
+  let batch = [];
+  let batchStart = 0;
+  let position = 0;
+  let replayed = 0;
+  for (let i = 0; i < lines.length;)
+  {
+    let record;
+    try
+    {
+      record = JSON.parse(lines[i]);
+    }
+    catch (e)
+    {
+      break;
+    }
+    if (!Array.isArray(record))
+      break;
+    let recordStart = position;
+    position += lines[i++].length + 1;
+
+    let [type, key, after] = record;
+    if (type == "end")
+    {
+      if (key !== recordStart - batchStart)
+        break;
+      for (let apply of batch)
+        apply();
+      batch = [];
+      batchStart = replayed = position;
+    }
+    else if (type == "set")
+    {
+      let count = record[3];
+      if (!(count >= 0) || i + count > lines.length)
+        break;
+      let content = lines.slice(i, i + count);
+      for (; count > 0; count--)
+        position += lines[i++].length + 1;
+      batch.push(() =>
+      {
+        sections.set(key, content);
+        order.insertAfter(key, after);
+      });
+    }
+    else if (type == "mov")
+      batch.push(() => order.insertAfter(key, after));
+    else if (type == "del")
+    {
+      batch.push(() =>
+      {
+        sections.delete(key);
+        order.remove(key);
+      });
+    }
+    else
+      break;
+  }
+  return replayed;
+}
+
+function readJournaled(fileName, journal, emit, state)
+{
+  let keys = [];
+  let sections = new Map();
+  let splitter = new SectionSplitter((key, lines) =>
+  {
+    keys.push(key);
+    sections.set(key, lines);
+  });
+
+  return readLinesAsync(fileName, line =>
+  {
+    state.baseSize += line.length + 1;
+    splitter.push(line);
+  }).then(() =>
+  {
+    splitter.finish();
+    let order = new SectionOrder(keys);
+    state.journalSize = replayJournal(journal, sections, order);
+    state.needsCompaction = state.journalSize != journal.length;
+
+    for (let key of order.keys())
+    {
+      let lines = sections.get(key);
+      if (lines)
+      {
+        for (let line of lines)
+          emit(line);
+      }
+    }
+  });
+}
+
+// Completes a rewrite of the file interrupted after the journal was renamed,
+// the temporary file is complete then. Leftovers of other interruptions are
+// removed.
+function finishCompleteWrite(fileName)
+{
+  let staleJournal = staleJournalFileName(fileName);
+  let tempFile = tempFileName(fileName);
+  return fileExistsAsync(staleJournal).then(hasStaleJournal =>
+  {
+    if (!hasStaleJournal)
+      return;
+
+    return Promise.all([
+      fileExistsAsync(journalFileName(fileName)),
+      fileExistsAsync(tempFile)
+    ]).then(([hasJournal, hasTempFile]) =>
+    {
+      if (!hasTempFile)
+        return;
+      if (hasJournal)
+        return removeFileIgnoringErrors(tempFile);
+      return moveFileAsync(tempFile, fileName);
+    }).then(() => removeFileIgnoringErrors(staleJournal));
+  });
+}
+
+// The file is written to a temporary file first. Only once it's complete the
+// journal is renamed, so that it isn't replayed on top of the new file, and
+// the temporary file replaces the file. IO.readFromFile() finishes the last
+// steps if they were interrupted. Resolves with `null` if the file was left
+// unchanged.
+function writeCompleteFile(fileName, generator, lineBreak, mayHaveJournal)
+{
+  let state = createJournalState();
+  let tracker = trackSections(state);
+  let lines = generator[Symbol.iterator]();
+  let changes = storageChanges;
+
+  let tempFile = tempFileName(fileName);
+  let isEmpty = true;
+  return writeChunks(_fileSystem.openWrite(tempFile), () =>
+  {
+    let chunk = "";
+    while (chunk.length < WRITE_CHUNK_SIZE)
+    {
+      let {value, done} = lines.next();
+      if (done)
+        break;
+      let line = String(value);
+      tracker.push(line);
+      state.baseSize += line.length + lineBreak.length;
+      chunk += line + lineBreak;
+    }
+
+    if (!chunk && isEmpty)
+      chunk = lineBreak;
+    isEmpty = false;
+    return chunk;
+  }).then(() =>
+  {
+    // The generator is resumed after each chunk is written, the file could
+    // mix two states of the storage if it changed in the meantime. It's
+    // dropped then, core saves again after the change.
+    if (storageChanges != changes)
+      return removeFileIgnoringErrors(tempFile).then(() => null);
+
+    tracker.finish();
+    let moveJournal = Promise.resolve(false);
+    if (mayHaveJournal)
+    {
+      let journal = journalFileName(fileName);
+      moveJournal = fileExistsAsync(journal).then(hasJournal =>
+        hasJournal && moveFileAsync(journal, staleJournalFileName(fileName)).then(() => true));
+    }
+    return moveJournal.then(hadJournal =>
+      moveFileAsync(tempFile, fileName).then(() =>
+      {
+        if (hadJournal)
+          return removeFileIgnoringErrors(staleJournalFileName(fileName));
+      })
+    ).then(() => state);
+  });
+}
+
+function appendToJournal(fileName, lines, state)
+{
+  let newState = createJournalState();
+  newState.baseSize = state.baseSize;
+  newState.journalSize = state.journalSize;
+
+  // Only the lines of changed sections are kept.
+  let sections = [];
+  let splitter = new SectionSplitter((key, sectionLines) =>
+  {
+    newState.keys.push(key);
+    newState.sections.set(key, sectionLines);
+    let changed = !sameLines(state.sections.get(key), sectionLines);
+    sections.push({key, lines: changed ? sectionLines : null});
+  });
+  for (let line of lines)
+    splitter.push(String(line));
+  splitter.finish();
+
+  let order = new SectionOrder(state.keys);
+  let records = [];
+  for (let key of state.keys)
+  {
+    if (!newState.sections.has(key))
+    {
+      records.push(JSON.stringify(["del", key]));
+      order.remove(key);
+    }
+  }
+
+  let after = null;
+  for (let {key, lines: sectionLines} of sections)
+  {
+    if (sectionLines)
+    {
+      records.push(JSON.stringify(["set", key, after, sectionLines.length]));
+      for (let line of sectionLines)
+        records.push(line);
+      order.insertAfter(key, after);
+    }
+    else if (order.previous(key) !== after)
+    {
+      records.push(JSON.stringify(["mov", key, after]));
+      order.insertAfter(key, after);
+    }
+    after = key;
+  }
+
+  if (records.length == 0)
+    return Promise.resolve(newState);
+
+  let text = records.join("\n") + "\n";
+  text += JSON.stringify(["end", text.length]) + "\n";
+  newState.journalSize += text.length;
+  return writeChunks(_fileSystem.openAppend(journalFileName(fileName)), () =>
+  {
+    let chunk = text;
+    text = "";
+    return chunk;
+  }).then(() => newState);
+}
+
 exports.IO =
 {
   lineBreak: "\n",
 
   readFromFile(fileName, listener)
   {
-    return new Promise((resolve, reject) =>
+    journalStates.delete(fileName);
+    let state = createJournalState();
+    let tracker = trackSections(state);
+    let emit = line =>
+    {
+      tracker.push(line);
+      listener(line);
+    };
+
+    return finishCompleteWrite(fileName).then(
+      () => readFileAsync(journalFileName(fileName))
+    ).then(
+      journal => readJournaled(fileName, journal.content, emit, state),
+      () => fileExistsAsync(journalFileName(fileName)).then(hasJournal =>
+      {
+        // A journal which couldn't be read mustn't be appended to.
+        state.needsCompaction = hasJournal;
+        return readLinesAsync(fileName, line =>
+        {
+          state.baseSize += line.length + 1;
+          emit(line);
+        });
+      })
+    ).then(() =>
     {
-      _fileSystem.readFromFile(fileName, listener, resolve, reject);
+      tracker.finish();
+      journalStates.set(fileName, state);
     });
   },
 
   writeToFile(fileName, generator)
   {
-    let content = Array.from(generator).join(this.lineBreak) + this.lineBreak;
-    return writeFileAsync(fileName, content);
+    let state = journalStates.get(fileName);
+    // The state of the file is unknown until the write succeeds.
+    journalStates.delete(fileName);
+
+    let journalSizeLimit = state && Math.max(MIN_JOURNAL_SIZE_LIMIT,
+                                             state.baseSize * JOURNAL_SIZE_LIMIT_RATIO);
+    let write;
+    if (state && !state.needsCompaction && state.journalSize <= journalSizeLimit)
+    {
+      // The changed sections are collected before anything is written.
+      try
+      {
+        write = appendToJournal(fileName, generator, state);
+      }
+      catch (error)
+      {
+        return Promise.reject(error);
+      }
+    }
+    else
+    {
+      write = writeCompleteFile(fileName, generator, this.lineBreak,
+                                !state || state.journalSize > 0 || state.needsCompaction);
+    }
+    return write.then(newState =>
+    {
+      if (newState)
+        journalStates.set(fileName, newState);
+      else if (state)
+        journalStates.set(fileName, state);
+    });
+  },
+
+  notifyStorageChange()
+  {
+    storageChanges++;
   },
 
   copyFile(fromFileName, toFileName)
   {
-    return readFileAsync(fromFileName).then(
-      content => writeFileAsync(toFileName, content));
+    journalStates.delete(toFileName);
+    let copy = (from, to) => readFileAsync(from).then(
+      result => writeFileAsync(to, result.content));
+
+    return copy(fromFileName, toFileName).then(
+      () => copy(journalFileName(fromFileName), journalFileName(toFileName)).catch(
+        () => removeFileIgnoringErrors(journalFileName(toFileName))));
   },
 
   renameFile(fromFileName, newNameFile)
@@ -70,7 +676,20 @@ exports.IO =
       {
         if (error)
           return reject(error);
-        resolve();
+
+        let state = journalStates.get(fromFileName);
+        journalStates.delete(fromFileName);
+        journalStates.delete(newNameFile);
+        _fileSystem.move(journalFileName(fromFileName), journalFileName(newNameFile),
+          journalError =>
+          {
+            if (state)
+              journalStates.set(newNameFile, state);
+            if (!journalError)
+              return resolve();
+            // There was no journal, the one of the old file is outdated.
+            removeFileIgnoringErrors(journalFileName(newNameFile)).then(resolve);
+          });
       });
     });
   },
@@ -83,7 +702,8 @@ exports.IO =
       {
         if (error)
           return reject(error);
-        resolve();
+        journalStates.delete(fileName);
+        removeFileIgnoringErrors(journalFileName(fileName)).then(resolve);
       });
     });
   },
@@ -59,6 +59,40 @@ let listeners = [];
 let specificListeners = new Map();
 let isDirty = false;
 let isSaving = false;
+// Set while a write is waiting for SAVE_DELAY, the timer doesn't write if
+// flushPrefs() replaced it meanwhile.
+let scheduledSave = null;
+
+// Changes made within this many milliseconds are written to prefs.json
+// together.
+const SAVE_DELAY = 1000;
+
+function checkType(key, value)
+{
+  if (typeof value != typeof defaults[key])
+    throw new Error("Attempt to change preference type");
+}
+
+function setValue(key, value)
+{
+  if (value == defaults[key])
+    delete values[key];
+  else
+    values[key] = value;
+}
+
+function notifyListeners(key)
+{
+  for (let listener of listeners)
+    listener(key);
+
+  let listeners_ = specificListeners.get(key);
+  if (listeners_)
+  {
+    for (let listener of listeners_)
+      listener(key);
+  }
+}
 
 function defineProperty(key)
 {
@@ -67,29 +101,38 @@ function defineProperty(key)
       get: () => values[key],
       set(value)
       {
-        if (typeof value != typeof defaults[key])
-          throw new Error("Attempt to change preference type");
-
-        if (value == defaults[key])
-          delete values[key];
-        else
-          values[key] = value;
+        checkType(key, value);
+        setValue(key, value);
         save();
-
-        for (let listener of listeners)
-          listener(key);
-
-        let listeners_ = specificListeners.get(key);
-        if (listeners_)
-        {
-          for (let listener of listeners_)
-            listener(key);
-        }
+        notifyListeners(key);
       },
       enumerable: true
     });
 }
 
+/**
+ * Changes several preferences at once, they are saved together and listeners
+ * are only notified once all of them are changed.
+ * @param {Object} updates preference values by name
+ */
+exports.setPrefs = function(updates)
+{
+  let keys = Object.keys(updates);
+  for (let key of keys)
+  {
+    if (!(key in defaults))
+      throw new Error("Unknown preference " + key);
+    checkType(key, updates[key]);
+  }
+
+  for (let key of keys)
+    setValue(key, updates[key]);
+  if (keys.length)
+    save();
+  for (let key of keys)
+    notifyListeners(key);
+};
+
 let initializePrefs = exports.initializePrefs = function()
 {
   return new Promise((resolve, reject) =>
@@ -119,6 +162,30 @@ let initializePrefs = exports.initializePrefs = function()
 }
 
 function save()
+{
+  if (scheduledSave)
+    return;
+
+  let thisSave = scheduledSave = {};
+  setTimeout(() =>
+  {
+    if (scheduledSave == thisSave)
+      flushPrefs();
+  }, SAVE_DELAY);
+}
+
+// Starts the write of changes waiting for SAVE_DELAY right away, e.g. when
+// the engine is shut down.
+let flushPrefs = exports.flushPrefs = function()
+{
+  if (!scheduledSave)
+    return;
+
+  scheduledSave = null;
+  write();
+};
+
+function write()
 {
   if (isSaving)
   {
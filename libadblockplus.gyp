@@ -64,6 +64,7 @@
     'xcode_settings':{},
     'include_dirs': [
       'include',
+      'src',
       '<(libv8_include_dir)'
     ],
     'sources': [
@@ -84,6 +85,7 @@
       'include/AdblockPlus/Platform.h',
       'include/AdblockPlus/PlatformFactory.h',
       'include/AdblockPlus/ReferrerMapping.h',
+      'include/AdblockPlus/StartupTimeline.h',
       'include/AdblockPlus/Subscription.h',
       'src/ActiveObject.cpp',
       'src/ActiveObject.h',
@@ -91,6 +93,8 @@
       'src/AsyncExecutor.h',
       'src/AppInfoJsObject.cpp',
       'src/AppInfoJsObject.h',
+      'src/CompressingFileSystem.cpp',
+      'src/CompressingFileSystem.h',
       'src/ConsoleJsObject.cpp',
       'src/ConsoleJsObject.h',
       'src/DefaultFileSystem.cpp',
@@ -115,10 +119,13 @@
       'src/FileSystemJsObject.h',
       'src/Filter.cpp',
       'src/FilterEngineFactory.cpp',
+      'src/FilterListPreparser.cpp',
+      'src/FilterListPreparser.h',
       'src/GlobalJsObject.cpp',
       'src/GlobalJsObject.h',
       'src/ElementUtils.cpp',
       'src/ElementUtils.h',
+      'src/IFileSystem.cpp',
       'src/IFilterEngine.cpp',
       'src/JsContext.cpp',
       'src/JsContext.h',
@@ -126,15 +133,22 @@
       'src/JsEngine.h',
       'src/JsError.cpp',
       'src/JsError.h',
+      'src/JsSources.h',
       'src/JsValue.cpp',
       'src/PlatformFactory.cpp',
+      'src/PrioritizedActiveObject.cpp',
+      'src/PrioritizedActiveObject.h',
       'src/ReferrerMapping.cpp',
       'src/ResourceReaderJsObject.cpp',
       'src/ResourceReaderJsObject.h',
+      'src/SignatureVerifier.cpp',
+      'src/SignatureVerifier.h',
       'src/Subscription.cpp',
       'src/SynchronizedCollection.h',
       'src/Thread.cpp',
       'src/Thread.h',
+      'src/TraceRecorder.cpp',
+      'src/TraceRecorder.h',
       'src/Utils.cpp',
       'src/Utils.h',
       'src/WebRequestJsObject.cpp',
@@ -25,6 +25,7 @@
 #include "GcCommand.h"
 #include "HelpCommand.h"
 #include "MatchesCommand.h"
+#include "ReplayCommand.h"
 #include "SubscriptionsCommand.h"
 
 #ifdef HAVE_CURL
@@ -53,9 +54,28 @@ namespace
     lineStream >> name;
     std::getline(lineStream, arguments);
   }
+
+  void RunCommand(const CommandMap& commands, const std::string& commandLine)
+  {
+    std::string commandName;
+    std::string arguments;
+    ParseCommandLine(commandLine, commandName, arguments);
+    const CommandMap::const_iterator it = commands.find(commandName);
+    try
+    {
+      if (it != commands.end())
+        (*it->second)(arguments);
+      else
+        throw NoSuchCommandError(commandName);
+    }
+    catch (NoSuchCommandError error)
+    {
+      std::cout << error.what() << std::endl;
+    }
+  }
 }
 
-int main()
+int main(int argc, char* argv[])
 {
   try
   {
@@ -86,6 +106,18 @@ int main()
     Add(commands, std::make_unique<FiltersCommand>(filterEngine));
     Add(commands, std::make_unique<SubscriptionsCommand>(filterEngine));
     Add(commands, std::make_unique<MatchesCommand>(filterEngine));
+    Add(commands, std::make_unique<ReplayCommand>(filterEngine));
+
+    // A command given on the command line is run instead of the interactive
+    // shell, e.g. `abpshell replay --json data/rec_*.log`.
+    if (argc > 1)
+    {
+      std::string commandLine = argv[1];
+      for (int i = 2; i < argc; ++i)
+        commandLine += std::string(" ") + argv[i];
+      RunCommand(commands, commandLine);
+      return 0;
+    }
 
     std::string commandLine;
     while (ReadCommandLine(commandLine))
@@ -94,21 +126,7 @@ int main()
       {
         break;
       }
-      std::string commandName;
-      std::string arguments;
-      ParseCommandLine(commandLine, commandName, arguments);
-      const CommandMap::const_iterator it = commands.find(commandName);
-      try
-      {
-        if (it != commands.end())
-          (*it->second)(arguments);
-        else
-          throw NoSuchCommandError(commandName);
-      }
-      catch (NoSuchCommandError error)
-      {
-        std::cout << error.what() << std::endl;
-      }
+      RunCommand(commands, commandLine);
     }
   }
   catch (const std::exception& e)
@@ -0,0 +1,223 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ReplayCommand.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include "TraceWorkload.h"
+
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+  typedef std::map<TraceOperation::Type, std::vector<double>> Latencies;
+
+  const double kPercentiles[] = {50, 90, 99, 99.9};
+  const char* const kPercentileNames[] = {"p50", "p90", "p99", "p99.9"};
+
+  struct Settings
+  {
+    int warmup = 1;
+    int iterations = 1;
+    int threads = 1;
+    double rate = 0;
+    bool json = false;
+    std::vector<std::string> files;
+  };
+
+  bool ParseSettings(const std::string& arguments, Settings& settings)
+  {
+    std::istringstream argumentStream(arguments);
+    std::string argument;
+    while (argumentStream >> argument)
+    {
+      if (argument == "--json")
+        settings.json = true;
+      else if (argument == "--warmup")
+        argumentStream >> settings.warmup;
+      else if (argument == "--iterations")
+        argumentStream >> settings.iterations;
+      else if (argument == "--threads")
+        argumentStream >> settings.threads;
+      else if (argument == "--rate")
+        argumentStream >> settings.rate;
+      else if (argument.compare(0, 2, "--") == 0)
+        return false;
+      else
+        settings.files.push_back(argument);
+      if (argumentStream.fail())
+        return false;
+    }
+    return !settings.files.empty() && settings.warmup >= 0 && settings.iterations > 0 &&
+           settings.threads > 0 && settings.rate >= 0;
+  }
+
+  void ReportTable(const Latencies& latencies, double seconds)
+  {
+    std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(38) << "Name"
+              << " ;      Count ;      Ops/s ;   p50(us) ;   p90(us) ;   p99(us) ; p99.9(us) ;"
+                 "   Max(us)"
+              << std::endl;
+    for (const auto& entry : latencies)
+    {
+      const auto& values = entry.second;
+      std::cout << std::left << std::setw(38) << GetTraceOperationName(entry.first) << " ; "
+                << std::right
+                << std::setw(10) << values.size() << " ; " << std::setw(10)
+                << values.size() / seconds;
+      for (double percentile : kPercentiles)
+        std::cout << " ; " << std::setw(9) << Percentile(values, percentile);
+      std::cout << " ; " << std::setw(9) << values.back() << std::endl;
+    }
+  }
+
+  void ReportJson(const Latencies& latencies, double seconds, const Settings& settings)
+  {
+    size_t total = 0;
+    for (const auto& entry : latencies)
+      total += entry.second.size();
+
+    std::cout << std::fixed << std::setprecision(3) << "{\"warmup\":" << settings.warmup
+              << ",\"iterations\":" << settings.iterations << ",\"threads\":" << settings.threads
+              << ",\"rate\":" << settings.rate << ",\"seconds\":" << seconds
+              << ",\"throughput\":" << total / seconds << ",\"operations\":{";
+    bool isFirst = true;
+    for (const auto& entry : latencies)
+    {
+      const auto& values = entry.second;
+      if (!isFirst)
+        std::cout << ",";
+      isFirst = false;
+      std::cout << "\"" << GetTraceOperationName(entry.first) << "\":{\"count\":" << values.size()
+                << ",\"throughput\":" << values.size() / seconds;
+      for (size_t i = 0; i < sizeof(kPercentiles) / sizeof(kPercentiles[0]); ++i)
+      {
+        std::cout << ",\"" << kPercentileNames[i]
+                  << "\":" << Percentile(values, kPercentiles[i]);
+      }
+      std::cout << ",\"max\":" << values.back() << "}";
+    }
+    std::cout << "}}" << std::endl;
+  }
+}
+
+ReplayCommand::ReplayCommand(AdblockPlus::IFilterEngine& filterEngine)
+    : Command("replay"), filterEngine(filterEngine)
+{
+}
+
+void ReplayCommand::operator()(const std::string& arguments)
+{
+  Settings settings;
+  if (!ParseSettings(arguments, settings))
+  {
+    ShowUsage();
+    return;
+  }
+
+  // Traces are parsed natively, so that the measured heap stays the same.
+  std::vector<TraceOperation> operations;
+  for (const auto& fileName : settings.files)
+  {
+    if (!LoadTrace(fileName, operations))
+    {
+      std::cerr << "Unable to read " << fileName << std::endl;
+      return;
+    }
+  }
+  if (operations.empty())
+  {
+    std::cerr << "No operations to replay" << std::endl;
+    return;
+  }
+
+  // Each thread takes the next operation from the shared sequence, with a
+  // target rate operations are started on schedule and their latency
+  // includes the time they waited for a free thread.
+  auto run = [this, &operations, &settings](int passes, Latencies& latencies) {
+    const size_t total = operations.size() * passes;
+    const auto start = Clock::now();
+    std::atomic<size_t> next(0);
+    std::vector<Latencies> threadLatencies(settings.threads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < settings.threads; ++i)
+    {
+      threads.emplace_back([&, i]() {
+        for (size_t index; (index = next++) < total;)
+        {
+          const auto& operation = operations[index % operations.size()];
+          auto scheduled = Clock::now();
+          if (settings.rate > 0)
+          {
+            scheduled = start + std::chrono::duration_cast<Clock::duration>(
+                                    std::chrono::duration<double>(index / settings.rate));
+            std::this_thread::sleep_until(scheduled);
+          }
+          ReplayTraceOperation(filterEngine, operation);
+          threadLatencies[i][operation.type].push_back(
+              std::chrono::duration<double, std::micro>(Clock::now() - scheduled).count());
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (const auto& thread : threadLatencies)
+    {
+      for (const auto& entry : thread)
+      {
+        auto& values = latencies[entry.first];
+        values.insert(values.end(), entry.second.begin(), entry.second.end());
+      }
+    }
+    for (auto& entry : latencies)
+      std::sort(entry.second.begin(), entry.second.end());
+    return seconds;
+  };
+
+  Latencies latencies;
+  if (settings.warmup > 0)
+    run(settings.warmup, latencies);
+  latencies = Latencies();
+  double seconds = run(settings.iterations, latencies);
+
+  if (settings.json)
+    ReportJson(latencies, seconds, settings);
+  else
+    ReportTable(latencies, seconds);
+}
+
+std::string ReplayCommand::GetDescription() const
+{
+  return "Replays recorded filter engine calls, such as data/rec_*.log, and reports their "
+         "latency";
+}
+
+std::string ReplayCommand::GetUsage() const
+{
+  return name + " [--warmup PASSES] [--iterations PASSES] [--threads COUNT] [--rate OPS_PER_SEC]"
+                " [--json] FILE...";
+}
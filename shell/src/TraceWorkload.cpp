@@ -0,0 +1,463 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TraceWorkload.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <map>
+
+namespace
+{
+  const char* const kOperationNames[] = {"check-filter-match",
+                                         "generate-js-css",
+                                         "block-popup",
+                                         "matches",
+                                         "is-content-allowlisted",
+                                         "get-element-hiding-style-sheet",
+                                         "get-element-hiding-emulation-selectors"};
+
+  enum class PopupBlockResult
+  {
+    NO_RULE,
+    BLOCK_RULE,
+    ALLOW_RULE,
+    DISABLED
+  };
+
+  // Times the engine calls of a browser call, only if there is an observer.
+  class CallTimer
+  {
+  public:
+    CallTimer(const TraceOperation& operation, const TraceCallObserver& observer)
+        : prefix(std::string(GetTraceOperationName(operation.type)) + "/"), observer(observer)
+    {
+    }
+
+    template<typename Call> auto operator()(const char* part, Call call) -> decltype(call())
+    {
+      if (!observer)
+        return call();
+      const auto started = std::chrono::steady_clock::now();
+      auto result = call();
+      observer(prefix + part,
+               std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                         started)
+                   .count());
+      return result;
+    }
+
+  private:
+    const std::string prefix;
+    const TraceCallObserver& observer;
+  };
+
+  // Fields of a trace line, numbers and booleans are kept as text.
+  struct TraceFields
+  {
+    std::map<std::string, std::string> values;
+    std::map<std::string, std::vector<std::string>> lists;
+
+    const std::string& Get(const std::string& name) const
+    {
+      static const std::string empty;
+      auto it = values.find(name);
+      return it == values.end() ? empty : it->second;
+    }
+
+    int GetInt(const std::string& name) const
+    {
+      const std::string& value = Get(name);
+      if (value == "true")
+        return 1;
+      if (value == "false" || value.empty())
+        return 0;
+      return std::stoi(value);
+    }
+  };
+
+  // Parses the flat JSON objects of the trace files natively, so parsing
+  // doesn't touch the measured JS heap.
+  class TraceLineParser
+  {
+  public:
+    explicit TraceLineParser(const std::string& line) : it(line.begin()), end(line.end())
+    {
+    }
+
+    bool Parse(TraceFields& fields)
+    {
+      if (!Consume('{'))
+        return false;
+      if (Consume('}'))
+        return true;
+      do
+      {
+        std::string name;
+        if (!ParseString(name) || !Consume(':'))
+          return false;
+        SkipSpaces();
+        if (it != end && *it == '[')
+        {
+          if (!ParseList(fields.lists[name]))
+            return false;
+        }
+        else if (!ParseValue(fields.values[name]))
+          return false;
+      } while (Consume(','));
+      return Consume('}');
+    }
+
+  private:
+    std::string::const_iterator it;
+    std::string::const_iterator end;
+
+    void SkipSpaces()
+    {
+      while (it != end && std::isspace(static_cast<unsigned char>(*it)))
+        ++it;
+    }
+
+    bool Consume(char c)
+    {
+      SkipSpaces();
+      if (it == end || *it != c)
+        return false;
+      ++it;
+      return true;
+    }
+
+    bool ParseList(std::vector<std::string>& list)
+    {
+      if (!Consume('['))
+        return false;
+      if (Consume(']'))
+        return true;
+      do
+      {
+        list.emplace_back();
+        if (!ParseValue(list.back()))
+          return false;
+      } while (Consume(','));
+      return Consume(']');
+    }
+
+    bool ParseValue(std::string& value)
+    {
+      SkipSpaces();
+      if (it != end && *it == '"')
+        return ParseString(value);
+      while (it != end && *it != ',' && *it != '}' && *it != ']' &&
+             !std::isspace(static_cast<unsigned char>(*it)))
+        value += *it++;
+      return !value.empty();
+    }
+
+    bool ParseString(std::string& value)
+    {
+      if (!Consume('"'))
+        return false;
+      while (it != end && *it != '"')
+      {
+        if (*it != '\\')
+        {
+          value += *it++;
+          continue;
+        }
+        if (++it == end)
+          return false;
+        char escaped = *it++;
+        switch (escaped)
+        {
+        case 'b':
+          value += '\b';
+          break;
+        case 'f':
+          value += '\f';
+          break;
+        case 'n':
+          value += '\n';
+          break;
+        case 'r':
+          value += '\r';
+          break;
+        case 't':
+          value += '\t';
+          break;
+        case 'u':
+        {
+          uint32_t codePoint;
+          if (!ParseHex(codePoint))
+            return false;
+          if (codePoint >= 0xD800 && codePoint < 0xDC00)
+          {
+            uint32_t low;
+            if (end - it < 2 || *it++ != '\\' || *it++ != 'u' || !ParseHex(low))
+              return false;
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+          }
+          AppendUtf8(value, codePoint);
+          break;
+        }
+        default:
+          value += escaped;
+        }
+      }
+      return it != end && *it++ == '"';
+    }
+
+    bool ParseHex(uint32_t& value)
+    {
+      if (end - it < 4)
+        return false;
+      value = std::stoul(std::string(it, it + 4), nullptr, 16);
+      it += 4;
+      return true;
+    }
+
+    static void AppendUtf8(std::string& value, uint32_t codePoint)
+    {
+      if (codePoint < 0x80)
+        value += static_cast<char>(codePoint);
+      else if (codePoint < 0x800)
+      {
+        value += static_cast<char>(0xC0 | (codePoint >> 6));
+        value += static_cast<char>(0x80 | (codePoint & 0x3F));
+      }
+      else if (codePoint < 0x10000)
+      {
+        value += static_cast<char>(0xE0 | (codePoint >> 12));
+        value += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        value += static_cast<char>(0x80 | (codePoint & 0x3F));
+      }
+      else
+      {
+        value += static_cast<char>(0xF0 | (codePoint >> 18));
+        value += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        value += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        value += static_cast<char>(0x80 | (codePoint & 0x3F));
+      }
+    }
+  };
+}
+
+std::vector<std::string> GetTraceFiles()
+{
+  // The traces are named after the host, see data/update.sh.
+  std::vector<std::string> files;
+  std::ifstream sites("data/sites.txt");
+  std::string url;
+  while (std::getline(sites, url))
+  {
+    size_t hostStart = url.find("://");
+    if (hostStart == std::string::npos)
+      continue;
+    hostStart += 3;
+    std::string host = url.substr(hostStart, url.find('/', hostStart) - hostStart);
+    std::replace(host.begin(), host.end(), '.', '_');
+    std::string file = "data/rec_" + host + ".log";
+    if (std::find(files.begin(), files.end(), file) == files.end())
+      files.push_back(file);
+  }
+  return files;
+}
+
+bool LoadTrace(const std::string& fileName, std::vector<TraceOperation>& workload)
+{
+  std::ifstream stream(fileName);
+  if (!stream.is_open())
+    return false;
+
+  std::string line;
+  while (std::getline(stream, line))
+  {
+    if (line.empty())
+      continue;
+    TraceFields fields;
+    if (!TraceLineParser(line).Parse(fields))
+      return false;
+
+    TraceOperation operation;
+    const std::string& fn = fields.Get("_fn");
+    if (fn == "check-filter-match")
+    {
+      operation.type = TraceOperation::Type::CHECK_FILTER_MATCH;
+      operation.url = fields.Get("request_url");
+      operation.contentType = fields.GetInt("adblock_resource_type");
+    }
+    else if (fn == "generate-js-css")
+    {
+      operation.type = TraceOperation::Type::GENERATE_JS_CSS;
+      operation.url = fields.Get("gurl");
+      operation.processId = fields.GetInt("process_id");
+      operation.frameId = fields.GetInt("frame_id");
+    }
+    else if (fn == "block-popup")
+    {
+      operation.type = TraceOperation::Type::BLOCK_POPUP;
+      operation.url = fields.Get("url");
+      operation.documentUrls.push_back(fields.Get("opener"));
+    }
+    else if (fn == "matches")
+    {
+      operation.type = TraceOperation::Type::MATCHES;
+      operation.url = fields.Get("url");
+      operation.contentType = fields.GetInt("content_type");
+      operation.documentUrls.push_back(fields.Get("document_url"));
+      operation.specificOnly = fields.GetInt("specific_only") != 0;
+      operation.expectedFilter = fields.Get("_res");
+    }
+    else if (fn == "is-content-allowlisted")
+    {
+      operation.type = TraceOperation::Type::IS_CONTENT_ALLOWLISTED;
+      operation.url = fields.Get("url");
+      operation.contentType = fields.GetInt("content_type");
+      operation.documentUrls = fields.lists["referrers"];
+    }
+    else if (fn == "get-element-hiding-style-sheet")
+    {
+      operation.type = TraceOperation::Type::GET_ELEMENT_HIDING_STYLE_SHEET;
+      operation.url = fields.Get("domain");
+      operation.specificOnly = fields.GetInt("specific_only") != 0;
+    }
+    else if (fn == "get-element-hiding-emulation-selectors")
+    {
+      operation.type = TraceOperation::Type::GET_ELEMENT_HIDING_EMULATION_SELECTORS;
+      operation.url = fields.Get("domain");
+    }
+    else
+      continue;
+
+    if (operation.type == TraceOperation::Type::CHECK_FILTER_MATCH ||
+        operation.type == TraceOperation::Type::GENERATE_JS_CSS)
+    {
+      operation.documentUrls = fields.lists["referrers"];
+    }
+    operation.sitekey = fields.Get("sitekey");
+    if (operation.type != TraceOperation::Type::MATCHES)
+      operation.expectedResult = fields.GetInt("_res");
+    workload.push_back(std::move(operation));
+  }
+  return true;
+}
+
+const char* GetTraceOperationName(TraceOperation::Type type)
+{
+  return kOperationNames[static_cast<int>(type)];
+}
+
+TraceResult ReplayTraceOperation(AdblockPlus::IFilterEngine& engine,
+                                 const TraceOperation& operation,
+                                 const TraceCallObserver& observer)
+{
+  typedef AdblockPlus::IFilterEngine Engine;
+  const auto& url = operation.url;
+  const auto& documentUrls = operation.documentUrls;
+  const auto& sitekey = operation.sitekey;
+  const std::string parent = documentUrls.empty() ? "" : documentUrls.front();
+  CallTimer measure(operation, observer);
+  TraceResult result;
+
+  switch (operation.type)
+  {
+  case TraceOperation::Type::CHECK_FILTER_MATCH:
+  {
+    bool specificOnly = !documentUrls.empty() && measure("allowlist", [&]() {
+      return engine.IsContentAllowlisted(
+          url, Engine::CONTENT_TYPE_GENERICBLOCK, documentUrls, sitekey);
+    });
+    AdblockPlus::Filter filter = measure("match", [&]() {
+      return engine.Matches(url, operation.contentType, parent, sitekey, specificOnly);
+    });
+    bool decision =
+        filter.IsValid() && filter.GetType() != AdblockPlus::Filter::Type::TYPE_EXCEPTION;
+    if (decision && measure("allowlist", [&]() {
+          return engine.IsContentAllowlisted(
+              url, Engine::CONTENT_TYPE_DOCUMENT, documentUrls, sitekey);
+        }))
+    {
+      decision = false;
+    }
+    result.result = decision;
+    break;
+  }
+  case TraceOperation::Type::GENERATE_JS_CSS:
+  {
+    if (url.compare(0, 5, "http:") != 0 && url.compare(0, 6, "https:") != 0)
+      break;
+    bool isAllowlisted = measure("allowlist", [&]() {
+      return engine.IsContentAllowlisted(
+                 url, Engine::CONTENT_TYPE_DOCUMENT, documentUrls, sitekey) ||
+             engine.IsContentAllowlisted(url, Engine::CONTENT_TYPE_ELEMHIDE, documentUrls, sitekey);
+    });
+    if (isAllowlisted || operation.processId < 0 || operation.frameId < 0)
+      break;
+    measure("emulation", [&]() { return engine.GetElementHidingEmulationSelectors(url); });
+    bool specificOnly = measure("allowlist", [&]() {
+      return engine.IsContentAllowlisted(url, Engine::CONTENT_TYPE_GENERICHIDE, documentUrls);
+    });
+    measure("stylesheet", [&]() { return engine.GetElementHidingStyleSheet(url, specificOnly); });
+    break;
+  }
+  case TraceOperation::Type::BLOCK_POPUP:
+  {
+    AdblockPlus::Filter filter =
+        measure("match", [&]() { return engine.Matches(url, Engine::CONTENT_TYPE_POPUP, parent); });
+    PopupBlockResult popupResult = PopupBlockResult::NO_RULE;
+    if (filter.IsValid())
+    {
+      popupResult = filter.GetType() == AdblockPlus::Filter::Type::TYPE_EXCEPTION
+                        ? PopupBlockResult::ALLOW_RULE
+                        : PopupBlockResult::BLOCK_RULE;
+    }
+    result.result = static_cast<int>(popupResult);
+    break;
+  }
+  case TraceOperation::Type::MATCHES:
+  {
+    AdblockPlus::Filter filter =
+        engine.Matches(url, operation.contentType, parent, sitekey, operation.specificOnly);
+    if (filter.IsValid())
+      result.filter = filter.GetRaw();
+    break;
+  }
+  case TraceOperation::Type::IS_CONTENT_ALLOWLISTED:
+    result.result =
+        engine.IsContentAllowlisted(url, operation.contentType, documentUrls, sitekey);
+    break;
+  case TraceOperation::Type::GET_ELEMENT_HIDING_STYLE_SHEET:
+    result.result = static_cast<int>(
+        engine.GetElementHidingStyleSheet(url, operation.specificOnly).size());
+    break;
+  case TraceOperation::Type::GET_ELEMENT_HIDING_EMULATION_SELECTORS:
+    result.result = static_cast<int>(engine.GetElementHidingEmulationSelectors(url).size());
+    break;
+  }
+  return result;
+}
+
+double Percentile(const std::vector<double>& sorted, double percentile)
+{
+  if (sorted.empty())
+    return 0;
+  size_t rank = static_cast<size_t>(std::ceil(percentile / 100 * sorted.size()));
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
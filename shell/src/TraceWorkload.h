@@ -0,0 +1,97 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <AdblockPlus/IFilterEngine.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Call recorded in data/rec_*.log, prepared before measurements start.
+// Browser calls combine several engine calls, the other types are single
+// calls recorded by IFilterEngine::StartTraceRecording().
+struct TraceOperation
+{
+  enum class Type
+  {
+    CHECK_FILTER_MATCH,
+    GENERATE_JS_CSS,
+    BLOCK_POPUP,
+    MATCHES,
+    IS_CONTENT_ALLOWLISTED,
+    GET_ELEMENT_HIDING_STYLE_SHEET,
+    GET_ELEMENT_HIDING_EMULATION_SELECTORS
+  };
+
+  Type type;
+  // Also the domain passed to the element hiding calls.
+  std::string url;
+  std::vector<std::string> documentUrls;
+  std::string sitekey;
+  AdblockPlus::IFilterEngine::ContentTypeMask contentType = 0;
+  bool specificOnly = false;
+  int processId = -1;
+  int frameId = -1;
+  // Decision, or size of the result for element hiding calls.
+  int expectedResult = 0;
+  // Text of the matching filter for MATCHES, empty if none matched.
+  std::string expectedFilter;
+};
+
+/*
+ * Paths of the traces recorded for the sites in data/sites.txt.
+ */
+std::vector<std::string> GetTraceFiles();
+
+/*
+ * Parses a trace file natively and appends its operations to the workload.
+ * Returns false if the file can't be read or parsed.
+ */
+bool LoadTrace(const std::string& fileName, std::vector<TraceOperation>& workload);
+
+/*
+ * Name of the operation type as written to the trace files.
+ */
+const char* GetTraceOperationName(TraceOperation::Type type);
+
+// Called with the name and duration in microseconds of each engine call a
+// browser call is made of, such as "check-filter-match/allowlist".
+typedef std::function<void(const std::string& name, double microseconds)> TraceCallObserver;
+
+// Outcome of a replayed operation, compare with the expectations recorded in
+// TraceOperation.
+struct TraceResult
+{
+  int result = 0;
+  std::string filter;
+};
+
+/*
+ * Makes the same engine calls as ABP Chromium did when a browser call was
+ * recorded, or the single recorded engine call. The engine takes its lock for
+ * each call, as it would for the browser. The result of GENERATE_JS_CSS isn't
+ * recorded and stays 0.
+ */
+TraceResult ReplayTraceOperation(AdblockPlus::IFilterEngine& engine,
+                                 const TraceOperation& operation,
+                                 const TraceCallObserver& observer = TraceCallObserver());
+
+/*
+ * Nearest-rank percentile of sorted values, 0 if there are none.
+ */
+double Percentile(const std::vector<double>& sorted, double percentile);
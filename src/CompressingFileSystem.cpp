@@ -0,0 +1,372 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CompressingFileSystem.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace AdblockPlus;
+
+namespace
+{
+  // Marks compressed files, patterns.ini is text so it never starts with a
+  // byte above 0x7F.
+  const uint8_t kMagic[] = {0x89, 'A', 'B', 'P', 'Z', '\r', '\n', 0x1A};
+
+  // The file is a sequence of frames each starting with the size of the
+  // decompressed and the stored data, incompressible frames are stored as
+  // they are.
+  const size_t kFrameHeaderSize = 8;
+  const size_t kMaxFrameSize = 1 << 20;
+  const uint32_t kStoredFlag = 0x80000000u;
+
+  // LZ4 block format, see
+  // https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+  const size_t kMinMatch = 4;
+  const size_t kLastLiterals = 5;
+  const size_t kMatchSearchLimit = 12;
+  const size_t kMaxOffset = 65535;
+  const int kHashBits = 14;
+
+  uint32_t ReadUInt32(const uint8_t* data)
+  {
+    return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+  }
+
+  void AppendUInt32(IFileSystem::IOBuffer& output, uint32_t value)
+  {
+    for (int i = 0; i < 4; ++i)
+      output.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+
+  uint32_t Hash(uint32_t sequence)
+  {
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+  }
+
+  void AppendLength(IFileSystem::IOBuffer& output, size_t length)
+  {
+    for (; length >= 255; length -= 255)
+      output.push_back(255);
+    output.push_back(static_cast<uint8_t>(length));
+  }
+
+  void AppendSequence(IFileSystem::IOBuffer& output,
+                      const uint8_t* literals,
+                      size_t literalLength,
+                      size_t offset,
+                      size_t matchLength)
+  {
+    bool hasMatch = matchLength >= kMinMatch;
+    size_t tokenMatchLength = hasMatch ? matchLength - kMinMatch : 0;
+    output.push_back(static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) |
+                                          std::min<size_t>(tokenMatchLength, 15)));
+    if (literalLength >= 15)
+      AppendLength(output, literalLength - 15);
+    output.insert(output.end(), literals, literals + literalLength);
+    if (!hasMatch)
+      return;
+    output.push_back(static_cast<uint8_t>(offset));
+    output.push_back(static_cast<uint8_t>(offset >> 8));
+    if (tokenMatchLength >= 15)
+      AppendLength(output, tokenMatchLength - 15);
+  }
+
+  void CompressBlock(const uint8_t* data, size_t size, IFileSystem::IOBuffer& output)
+  {
+    size_t anchor = 0;
+    if (size > kMatchSearchLimit)
+    {
+      // Positions are stored plus one, zero is an empty slot.
+      std::vector<uint32_t> table(size_t(1) << kHashBits);
+      const size_t searchEnd = size - kMatchSearchLimit;
+      const size_t matchEnd = size - kLastLiterals;
+      size_t position = 0;
+      while (position < searchEnd)
+      {
+        uint32_t sequence = ReadUInt32(data + position);
+        uint32_t& slot = table[Hash(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(position + 1);
+        if (candidate == 0 || position + 1 - candidate > kMaxOffset ||
+            ReadUInt32(data + candidate - 1) != sequence)
+        {
+          // Skip faster through data which doesn't compress.
+          position += 1 + ((position - anchor) >> 6);
+          continue;
+        }
+
+        size_t match = candidate - 1;
+        size_t length = kMinMatch;
+        while (position + length < matchEnd && data[match + length] == data[position + length])
+          ++length;
+        AppendSequence(output, data + anchor, position - anchor, position - match, length);
+        position += length;
+        anchor = position;
+      }
+    }
+    AppendSequence(output, data + anchor, size - anchor, 0, 0);
+  }
+
+  bool ReadLength(const uint8_t*& input, const uint8_t* end, size_t& length)
+  {
+    uint8_t value;
+    do
+    {
+      if (input == end)
+        return false;
+      value = *input++;
+      length += value;
+    } while (value == 255);
+    return true;
+  }
+
+  bool DecompressBlock(const uint8_t* input,
+                       size_t size,
+                       size_t decompressedSize,
+                       IFileSystem::IOBuffer& output)
+  {
+    const uint8_t* end = input + size;
+    const size_t start = output.size();
+    output.resize(start + decompressedSize);
+    uint8_t* target = output.data() + start;
+    size_t written = 0;
+    while (input < end)
+    {
+      uint8_t token = *input++;
+      size_t literalLength = token >> 4;
+      if (literalLength == 15 && !ReadLength(input, end, literalLength))
+        return false;
+      if (literalLength > static_cast<size_t>(end - input) ||
+          literalLength > decompressedSize - written)
+        return false;
+      std::memcpy(target + written, input, literalLength);
+      input += literalLength;
+      written += literalLength;
+      if (input == end)
+        break;
+
+      if (end - input < 2)
+        return false;
+      size_t offset = input[0] | (input[1] << 8);
+      input += 2;
+      size_t matchLength = token & 15;
+      if (matchLength == 15 && !ReadLength(input, end, matchLength))
+        return false;
+      matchLength += kMinMatch;
+      if (offset == 0 || offset > written || matchLength > decompressedSize - written)
+        return false;
+      // Matches may overlap the bytes they produce.
+      const uint8_t* source = target + written - offset;
+      for (size_t i = 0; i < matchLength; ++i)
+        target[written + i] = source[i];
+      written += matchLength;
+    }
+    return written == decompressedSize;
+  }
+
+  void AppendFrames(const uint8_t* data, size_t size, IFileSystem::IOBuffer& output)
+  {
+    IFileSystem::IOBuffer block;
+    for (size_t offset = 0; offset < size; offset += kMaxFrameSize)
+    {
+      size_t frameSize = std::min(size - offset, kMaxFrameSize);
+      block.clear();
+      CompressBlock(data + offset, frameSize, block);
+      AppendUInt32(output, static_cast<uint32_t>(frameSize));
+      if (block.size() < frameSize)
+      {
+        AppendUInt32(output, static_cast<uint32_t>(block.size()));
+        output.insert(output.end(), block.begin(), block.end());
+      }
+      else
+      {
+        AppendUInt32(output, static_cast<uint32_t>(frameSize) | kStoredFlag);
+        output.insert(output.end(), data + offset, data + offset + frameSize);
+      }
+    }
+  }
+
+  bool IsCompressed(const IFileSystem::IOBuffer& data)
+  {
+    return data.size() >= sizeof(kMagic) &&
+           std::equal(kMagic, kMagic + sizeof(kMagic), data.begin());
+  }
+
+  class CompressingWriteStream : public IFileSystem::WriteStream
+  {
+  public:
+    explicit CompressingWriteStream(std::unique_ptr<IFileSystem::WriteStream> stream)
+        : stream(std::move(stream)), hasHeader(false)
+    {
+    }
+
+    void Write(IFileSystem::IOBuffer&& data, const IFileSystem::Callback& callback) override
+    {
+      IFileSystem::IOBuffer frames;
+      if (!hasHeader)
+      {
+        frames.assign(kMagic, kMagic + sizeof(kMagic));
+        hasHeader = true;
+      }
+      AppendFrames(data.data(), data.size(), frames);
+      stream->Write(std::move(frames), callback);
+    }
+
+    void Close(const IFileSystem::Callback& callback) override
+    {
+      if (!hasHeader)
+        Write(IFileSystem::IOBuffer(), [](const std::string&) {});
+      stream->Close(callback);
+    }
+
+  private:
+    std::unique_ptr<IFileSystem::WriteStream> stream;
+    bool hasHeader;
+  };
+}
+
+CompressingFileSystem::CompressingFileSystem(FileSystemPtr fileSystem,
+                                             const FileNamePredicate& shouldCompress)
+    : fileSystem(std::move(fileSystem)), shouldCompress(shouldCompress)
+{
+}
+
+// static
+bool CompressingFileSystem::IsFilterStorageFile(const std::string& fileName)
+{
+  static const std::string prefix = "patterns";
+  static const std::string suffix = ".ini";
+  size_t nameStart = fileName.find_last_of("/\\");
+  nameStart = nameStart == std::string::npos ? 0 : nameStart + 1;
+  return fileName.size() >= nameStart + prefix.size() + suffix.size() &&
+         fileName.compare(nameStart, prefix.size(), prefix) == 0 &&
+         fileName.compare(fileName.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// static
+IFileSystem::IOBuffer CompressingFileSystem::Compress(const IOBuffer& data)
+{
+  IOBuffer result(kMagic, kMagic + sizeof(kMagic));
+  AppendFrames(data.data(), data.size(), result);
+  return result;
+}
+
+// static
+bool CompressingFileSystem::Decompress(IOBuffer&& data, IOBuffer& result)
+{
+  if (!IsCompressed(data))
+  {
+    result = std::move(data);
+    return true;
+  }
+
+  result.clear();
+  const uint8_t* input = data.data() + sizeof(kMagic);
+  const uint8_t* end = data.data() + data.size();
+  while (input < end)
+  {
+    if (static_cast<size_t>(end - input) < kFrameHeaderSize)
+      return false;
+    uint32_t frameSize = ReadUInt32(input);
+    uint32_t storedSize = ReadUInt32(input + 4) & ~kStoredFlag;
+    bool isStored = (ReadUInt32(input + 4) & kStoredFlag) != 0;
+    input += kFrameHeaderSize;
+    if (frameSize > kMaxFrameSize || storedSize > static_cast<size_t>(end - input))
+      return false;
+
+    if (isStored)
+    {
+      if (storedSize != frameSize)
+        return false;
+      result.insert(result.end(), input, input + storedSize);
+    }
+    else if (!DecompressBlock(input, storedSize, frameSize, result))
+      return false;
+    input += storedSize;
+  }
+  return true;
+}
+
+void CompressingFileSystem::Read(const std::string& fileName,
+                                 const ReadCallback& doneCallback,
+                                 const Callback& errorCallback) const
+{
+  if (!shouldCompress(fileName))
+  {
+    fileSystem->Read(fileName, doneCallback, errorCallback);
+    return;
+  }
+
+  fileSystem->Read(
+      fileName,
+      [fileName, doneCallback, errorCallback](IOBuffer&& data) {
+        IOBuffer content;
+        if (!Decompress(std::move(data), content))
+        {
+          errorCallback("Corrupted compressed file " + fileName);
+          return;
+        }
+        doneCallback(std::move(content));
+      },
+      errorCallback);
+}
+
+void CompressingFileSystem::Write(const std::string& fileName,
+                                  const IOBuffer& data,
+                                  const Callback& callback)
+{
+  if (shouldCompress(fileName))
+    fileSystem->Write(fileName, Compress(data), callback);
+  else
+    fileSystem->Write(fileName, data, callback);
+}
+
+void CompressingFileSystem::Move(const std::string& fromFileName,
+                                 const std::string& toFileName,
+                                 const Callback& callback)
+{
+  fileSystem->Move(fromFileName, toFileName, callback);
+}
+
+void CompressingFileSystem::Remove(const std::string& fileName, const Callback& callback)
+{
+  fileSystem->Remove(fileName, callback);
+}
+
+void CompressingFileSystem::Stat(const std::string& fileName, const StatCallback& callback) const
+{
+  fileSystem->Stat(fileName, callback);
+}
+
+std::unique_ptr<IFileSystem::WriteStream>
+CompressingFileSystem::OpenWrite(const std::string& fileName)
+{
+  if (!shouldCompress(fileName))
+    return fileSystem->OpenWrite(fileName);
+  return std::unique_ptr<WriteStream>(new CompressingWriteStream(fileSystem->OpenWrite(fileName)));
+}
+
+std::unique_ptr<IFileSystem::WriteStream>
+CompressingFileSystem::OpenAppend(const std::string& fileName)
+{
+  // Compressed files are rewritten by the default implementation.
+  if (!shouldCompress(fileName))
+    return fileSystem->OpenAppend(fileName);
+  return IFileSystem::OpenAppend(fileName);
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <functional>
+
+#include <AdblockPlus/IFileSystem.h>
+
+namespace AdblockPlus
+{
+  /**
+   * File system decorator storing selected files compressed with the LZ4
+   * block format. Files written before compression was enabled are still
+   * read as they are, `Stat()`, `Move()` and `Remove()` are passed through
+   * unchanged.
+   */
+  class CompressingFileSystem : public IFileSystem
+  {
+  public:
+    typedef std::function<bool(const std::string& fileName)> FileNamePredicate;
+
+    /**
+     * @param fileSystem File system storing the files.
+     * @param shouldCompress Selects the files to compress, files moved
+     *        between selected and other names keep their contents.
+     */
+    explicit CompressingFileSystem(FileSystemPtr fileSystem,
+                                   const FileNamePredicate& shouldCompress = IsFilterStorageFile);
+
+    /**
+     * Selects patterns.ini and its backups.
+     */
+    static bool IsFilterStorageFile(const std::string& fileName);
+
+    /**
+     * Compresses complete file contents.
+     */
+    static IOBuffer Compress(const IOBuffer& data);
+
+    /**
+     * Decompresses file contents, data which isn't compressed is returned
+     * unchanged.
+     * @return `false` if the compressed data is corrupted.
+     */
+    static bool Decompress(IOBuffer&& data, IOBuffer& result);
+
+    void Read(const std::string& fileName,
+              const ReadCallback& doneCallback,
+              const Callback& errorCallback) const override;
+    void
+    Write(const std::string& fileName, const IOBuffer& data, const Callback& callback) override;
+    void Move(const std::string& fromFileName,
+              const std::string& toFileName,
+              const Callback& callback) override;
+    void Remove(const std::string& fileName, const Callback& callback) override;
+    void Stat(const std::string& fileName, const StatCallback& callback) const override;
+    std::unique_ptr<WriteStream> OpenWrite(const std::string& fileName) override;
+    std::unique_ptr<WriteStream> OpenAppend(const std::string& fileName) override;
+
+  private:
+    FileSystemPtr fileSystem;
+    FileNamePredicate shouldCompress;
+  };
+}
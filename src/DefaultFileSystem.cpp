@@ -66,6 +66,87 @@ namespace
     return path;
   }
 #endif
+
+  class DefaultWriteStream : public IFileSystem::WriteStream
+  {
+  public:
+    DefaultWriteStream(IExecutor& executor,
+                       DefaultFileSystemSync& syncImpl,
+                       const std::string& path,
+                       bool append)
+        : executor(executor), state(std::make_shared<State>(syncImpl, path, append))
+    {
+    }
+
+    void Write(IFileSystem::IOBuffer&& data, const IFileSystem::Callback& callback) override
+    {
+      // Chunks are moved into the task rather than copied.
+      auto chunk = std::make_shared<IFileSystem::IOBuffer>(std::move(data));
+      auto state = this->state;
+      executor.Dispatch([state, chunk, callback] {
+        if (state->Open())
+        {
+          state->file->write(reinterpret_cast<const char*>(chunk->data()), chunk->size());
+          if (state->file->fail())
+            state->error = "Failed to write to " + state->path;
+        }
+        callback(state->error);
+      });
+    }
+
+    void Close(const IFileSystem::Callback& callback) override
+    {
+      auto state = this->state;
+      executor.Dispatch([state, callback] {
+        if (state->Open())
+        {
+          state->file->flush();
+          if (state->file->fail())
+            state->error = "Failed to write to " + state->path;
+          state->file.reset();
+        }
+        callback(state->error);
+      });
+    }
+
+  private:
+    // Shared with the pending tasks, the stream can go away before they run.
+    struct State
+    {
+      State(DefaultFileSystemSync& syncImpl, const std::string& path, bool append)
+          : syncImpl(syncImpl), path(path), append(append), opened(false)
+      {
+      }
+
+      // Opens the file on first use, returns false if it's not writable.
+      bool Open()
+      {
+        if (!opened)
+        {
+          opened = true;
+          try
+          {
+            file = syncImpl.OpenWrite(path, append);
+          }
+          catch (std::exception& e)
+          {
+            error = e.what();
+          }
+        }
+        return error.empty() && file;
+      }
+
+      DefaultFileSystemSync& syncImpl;
+      std::string path;
+      bool append;
+      bool opened;
+      std::unique_ptr<std::ostream> file;
+      std::string error;
+    };
+
+    IExecutor& executor;
+    std::shared_ptr<State> state;
+  };
 }
 
 DefaultFileSystemSync::DefaultFileSystemSync(const std::string& path) : basePath(path)
@@ -97,6 +178,18 @@ void DefaultFileSystemSync::Write(const std::string& path, const IFileSystem::IO
   file.write(reinterpret_cast<const std::ofstream::char_type*>(data.data()), data.size());
 }
 
+std::unique_ptr<std::ostream> DefaultFileSystemSync::OpenWrite(const std::string& path,
+                                                               bool append)
+{
+  auto mode = std::ios_base::out | std::ios_base::binary;
+  if (append)
+    mode |= std::ios_base::app;
+  std::unique_ptr<std::ostream> file(new std::ofstream(NormalizePath(path).c_str(), mode));
+  if (file->fail())
+    throw RuntimeErrorWithErrno("Failed to open " + path);
+  return file;
+}
+
 void DefaultFileSystemSync::Move(const std::string& fromPath, const std::string& toPath)
 {
   if (rename(NormalizePath(fromPath).c_str(), NormalizePath(toPath).c_str()))
@@ -310,6 +403,20 @@ void DefaultFileSystem::Stat(const std::string& fileName, const StatCallback& ca
   });
 }
 
+std::unique_ptr<IFileSystem::WriteStream>
+DefaultFileSystem::OpenWrite(const std::string& fileName)
+{
+  return std::unique_ptr<WriteStream>(
+      new DefaultWriteStream(executor, *syncImpl, Resolve(fileName), false));
+}
+
+std::unique_ptr<IFileSystem::WriteStream>
+DefaultFileSystem::OpenAppend(const std::string& fileName)
+{
+  return std::unique_ptr<WriteStream>(
+      new DefaultWriteStream(executor, *syncImpl, Resolve(fileName), true));
+}
+
 std::string DefaultFileSystem::Resolve(const std::string& fileName) const
 {
   return syncImpl->Resolve(fileName);
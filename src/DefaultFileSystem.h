@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <ostream>
+
 #include <AdblockPlus/IExecutor.h>
 #include <AdblockPlus/IFileSystem.h>
 
@@ -40,6 +42,7 @@ namespace AdblockPlus
     explicit DefaultFileSystemSync(const std::string& basePath);
     IFileSystem::IOBuffer Read(const std::string& path) const;
     void Write(const std::string& path, const IFileSystem::IOBuffer& data);
+    std::unique_ptr<std::ostream> OpenWrite(const std::string& path, bool append);
     void Move(const std::string& fromPath, const std::string& toPath);
     void Remove(const std::string& path);
     IFileSystem::StatResult Stat(const std::string& path) const;
@@ -63,6 +66,8 @@ namespace AdblockPlus
               const Callback& callback) override;
     void Remove(const std::string& fileName, const Callback& callback) override;
     void Stat(const std::string& fileName, const StatCallback& callback) const override;
+    std::unique_ptr<WriteStream> OpenWrite(const std::string& fileName) override;
+    std::unique_ptr<WriteStream> OpenAppend(const std::string& fileName) override;
 
   private:
     // Returns the absolute path to a file.
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <functional>
 #include <string>
 
@@ -29,16 +30,46 @@
 
 using namespace AdblockPlus;
 
+namespace
+{
+  // Names of events which lib/filterUpdateRegistration.js can forward.
+  const char* const kEventNames[] = {"load",
+                                     "save",
+                                     "filter.added",
+                                     "filter.removed",
+                                     "filter.moved",
+                                     "filter.disabled",
+                                     "filter.hitCount",
+                                     "filter.lastHit",
+                                     "subscription.added",
+                                     "subscription.removed",
+                                     "subscription.disabled",
+                                     "subscription.downloading",
+                                     "subscription.downloadStatus",
+                                     "subscription.updated",
+                                     "subscription.errors",
+                                     "subscription.title",
+                                     "subscription.fixedTitle",
+                                     "subscription.homepage",
+                                     "subscription.lastCheck",
+                                     "subscription.lastDownload"};
+}
+
 DefaultFilterEngine::DefaultFilterEngine(JsEngine& jsEngine) : jsEngine(jsEngine)
 {
   jsEngine.SetEventCallback("filterChange", [this](JsValueList&& params) {
     this->OnSubscriptionOrFilterChanged(move(params));
   });
+  UpdateObservedEvents();
 }
 
 DefaultFilterEngine::~DefaultFilterEngine()
 {
   jsEngine.RemoveEventCallback("filterChange");
+  // Waits for delivering of already queued events.
+  eventDispatcher_.reset();
+  // Waits for already requested matches.
+  matchDispatcher_.reset();
 }
 
 Filter DefaultFilterEngine::GetFilter(const std::string& text) const
@@ -100,6 +131,25 @@ std::vector<Subscription> DefaultFilterEngine::GetListedSubscriptions() const
   return result;
 }
 
+std::vector<IFilterEngine::SubscriptionMemoryUsage>
+DefaultFilterEngine::GetSubscriptionMemoryUsage() const
+{
+  JsValue func = jsEngine.Evaluate("API.getSubscriptionMemoryUsage");
+  JsValueList values = func.Call().AsList();
+  std::vector<SubscriptionMemoryUsage> result;
+  result.reserve(values.size());
+  for (const auto& value : values)
+  {
+    SubscriptionMemoryUsage usage;
+    usage.url = value.GetProperty("url").AsString();
+    usage.filterCount = value.GetProperty("filterCount").AsInt();
+    usage.textBytes = value.GetProperty("textBytes").AsInt();
+    usage.estimatedBytes = value.GetProperty("estimatedBytes").AsInt();
+    result.push_back(usage);
+  }
+  return result;
+}
+
 std::vector<Subscription> DefaultFilterEngine::FetchAvailableSubscriptions() const
 {
   JsValue func = jsEngine.Evaluate("API.getRecommendedSubscriptions");
@@ -132,12 +182,83 @@ Filter DefaultFilterEngine::Matches(const std::string& url,
                                     const std::string& siteKey,
                                     bool specificOnly) const
 {
-  if (documentUrl.empty())
+  const auto started = std::chrono::steady_clock::now();
+  // An empty documentUrl means we are at the top of the frame hierarchy.
+  Filter filter = CheckFilterMatch(url, contentTypeMask, documentUrl, siteKey, specificOnly);
+  if (!firstMatchRecorded_.load(std::memory_order_relaxed) && !firstMatchRecorded_.exchange(true))
+    jsEngine.RecordStartupPhase("first Matches", started);
+  if (traceRecorder_.IsRecording())
   {
-    // We must be at the top of the frame hierarchy.
-    return CheckFilterMatch(url, contentTypeMask, "", siteKey, specificOnly);
+    traceRecorder_.Record(TraceRecorder::Line("matches")
+                              .AddString("url", url)
+                              .AddInt("content_type", contentTypeMask)
+                              .AddString("document_url", documentUrl)
+                              .AddString("sitekey", siteKey)
+                              .AddBool("specific_only", specificOnly)
+                              .AddString("_res", filter.IsValid() ? filter.GetRaw() : "")
+                              .Finish(started));
   }
-  return CheckFilterMatch(url, contentTypeMask, documentUrl, siteKey, specificOnly);
+  return filter;
+}
+
+Filter DefaultFilterEngine::Matches(const MatchRequest& request) const
+{
+  return Matches(request.url,
+                 request.contentTypeMask,
+                 request.documentUrl,
+                 request.siteKey,
+                 request.specificOnly);
+}
+
+void DefaultFilterEngine::PostMatchRequest(const MatchRequest& request,
+                                           std::function<void()>&& task) const
+{
+  std::lock_guard<std::mutex> lock(matchDispatcherMutex_);
+  if (!matchDispatcher_)
+    matchDispatcher_ = std::make_unique<PrioritizedActiveObject>();
+
+  jsEngine.BeginForegroundWork();
+  matchDispatcher_->Post(
+      [this, task] {
+        task();
+        jsEngine.EndForegroundWork();
+      },
+      GetMatchPriority(request.contentTypeMask));
+}
+
+void DefaultFilterEngine::MatchesAsync(const MatchRequest& request,
+                                       const MatchCallback& callback) const
+{
+  PostMatchRequest(request, [this, request, callback] {
+    Filter filter;
+    try
+    {
+      filter = Matches(request);
+    }
+    catch (const std::exception&)
+    {
+      // Reported as no match, the callback has to be called anyway.
+    }
+    if (callback)
+      callback(filter);
+  });
+}
+
+std::future<Filter> DefaultFilterEngine::MatchesAsync(const MatchRequest& request) const
+{
+  auto promise = std::make_shared<std::promise<Filter>>();
+  auto result = promise->get_future();
+  PostMatchRequest(request, [this, request, promise] {
+    try
+    {
+      promise->set_value(Matches(request));
+    }
+    catch (...)
+    {
+      promise->set_exception(std::current_exception());
+    }
+  });
+  return result;
 }
 
 bool DefaultFilterEngine::IsContentAllowlisted(const std::string& url,
@@ -145,7 +266,60 @@ bool DefaultFilterEngine::IsContentAllowlisted(const std::string& url,
                                                const std::vector<std::string>& documentUrls,
                                                const std::string& sitekey) const
 {
-  return GetAllowlistingFilter(url, contentTypeMask, documentUrls, sitekey).IsValid();
+  const auto started = std::chrono::steady_clock::now();
+  bool isAllowlisted = GetAllowlistingFilter(url, contentTypeMask, documentUrls, sitekey).IsValid();
+  if (traceRecorder_.IsRecording())
+  {
+    traceRecorder_.Record(TraceRecorder::Line("is-content-allowlisted")
+                              .AddString("url", url)
+                              .AddInt("content_type", contentTypeMask)
+                              .AddList("referrers", documentUrls)
+                              .AddString("sitekey", sitekey)
+                              .AddBool("_res", isAllowlisted)
+                              .Finish(started));
+  }
+  return isAllowlisted;
+}
+
+std::unique_ptr<IFilterEngine::FrameContext>
+DefaultFilterEngine::CreateFrameContext(const std::vector<std::string>& documentUrls,
+                                        const std::string& sitekey) const
+{
+  JsValueList params;
+  params.push_back(jsEngine.NewArray(documentUrls));
+  params.push_back(jsEngine.NewValue(sitekey));
+  params.push_back(jsEngine.NewValue(CONTENT_TYPE_DOCUMENT));
+  params.push_back(jsEngine.NewValue(CONTENT_TYPE_GENERICBLOCK));
+  JsValue func = jsEngine.Evaluate("API.createFrameContext");
+  return std::make_unique<DefaultFrameContext>(func.Call(params));
+}
+
+Filter DefaultFilterEngine::Matches(const std::string& url,
+                                    ContentTypeMask contentTypeMask,
+                                    const FrameContext& frame) const
+{
+  if (url.empty())
+    return Filter();
+  JsValue func = jsEngine.Evaluate("API.checkFilterMatchInFrame");
+  JsValueList params;
+  params.push_back(jsEngine.NewValue(url));
+  params.push_back(jsEngine.NewValue(contentTypeMask));
+  params.push_back(static_cast<const DefaultFrameContext&>(frame).jsObject);
+  JsValue result = func.Call(params);
+  if (!result.IsNull())
+    return Filter(std::make_unique<DefaultFilterImplementation>(std::move(result), &jsEngine));
+  else
+    return Filter();
+}
+
+bool DefaultFilterEngine::IsContentAllowlisted(ContentTypeMask contentTypeMask,
+                                               const FrameContext& frame) const
+{
+  JsValue func = jsEngine.Evaluate("API.isFrameAllowlisted");
+  JsValueList params;
+  params.push_back(jsEngine.NewValue(contentTypeMask));
+  params.push_back(static_cast<const DefaultFrameContext&>(frame).jsObject);
+  return func.Call(params).AsBool();
 }
 
 // |documentUrl| gets converted to a hostname (domain) within "API.checkFilterMatch".
@@ -174,22 +348,41 @@ Filter DefaultFilterEngine::CheckFilterMatch(const std::string& url,
 std::string DefaultFilterEngine::GetElementHidingStyleSheet(const std::string& domain,
                                                             bool specificOnly) const
 {
+  const auto started = std::chrono::steady_clock::now();
   JsValueList params;
   params.push_back(jsEngine.NewValue(domain));
   params.push_back(jsEngine.NewValue(specificOnly));
   JsValue func = jsEngine.Evaluate("API.getElementHidingStyleSheet");
-  return func.Call(params).AsString();
+  std::string styleSheet = func.Call(params).AsString();
+  if (traceRecorder_.IsRecording())
+  {
+    // Style sheets are large, only their size is recorded.
+    traceRecorder_.Record(TraceRecorder::Line("get-element-hiding-style-sheet")
+                              .AddString("domain", domain)
+                              .AddBool("specific_only", specificOnly)
+                              .AddInt("_res", styleSheet.size())
+                              .Finish(started));
+  }
+  return styleSheet;
 }
 
 std::vector<IFilterEngine::EmulationSelector>
 DefaultFilterEngine::GetElementHidingEmulationSelectors(const std::string& domain) const
 {
+  const auto started = std::chrono::steady_clock::now();
   JsValue func = jsEngine.Evaluate("API.getElementHidingEmulationSelectors");
   JsValueList result = func.Call(jsEngine.NewValue(domain)).AsList();
   std::vector<IFilterEngine::EmulationSelector> selectors;
   selectors.reserve(result.size());
   for (const auto& r : result)
     selectors.push_back({r.GetProperty("selector").AsString(), r.GetProperty("text").AsString()});
+  if (traceRecorder_.IsRecording())
+  {
+    traceRecorder_.Record(TraceRecorder::Line("get-element-hiding-emulation-selectors")
+                              .AddString("domain", domain)
+                              .AddInt("_res", selectors.size())
+                              .Finish(started));
+  }
   return selectors;
 }
 
@@ -208,19 +401,98 @@ void DefaultFilterEngine::SetPref(const std::string& pref, const JsValue& value)
   func.Call(params);
 }
 
-void DefaultFilterEngine::AddEventObserver(EventObserver* observer)
+void DefaultFilterEngine::AddEventObserver(EventObserver* observer,
+                                           EventMask mask,
+                                           EventDelivery delivery)
 {
-  std::unique_lock<std::mutex> lock(callbacksMutex_);
-  assert(std::find(observers_.begin(), observers_.end(), observer) == observers_.end());
-  observers_.push_back(observer);
+  auto isSameObserver = [observer](const RegisteredObserver& registered) {
+    return registered.observer == observer;
+  };
+  if (delivery == EventDelivery::QUEUED)
+  {
+    {
+      std::lock_guard<std::mutex> lock(eventQueueMutex_);
+      if (!eventDispatcher_)
+        eventDispatcher_.reset(new ActiveObject());
+    }
+    std::lock_guard<std::mutex> lock(queuedCallbacksMutex_);
+    assert(std::find_if(queuedObservers_.begin(), queuedObservers_.end(), isSameObserver) ==
+           queuedObservers_.end());
+    queuedObservers_.push_back({observer, mask});
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lock(callbacksMutex_);
+    assert(std::find_if(observers_.begin(), observers_.end(), isSameObserver) == observers_.end());
+    observers_.push_back({observer, mask});
+  }
+  UpdateObservedEvents();
 }
 
 void DefaultFilterEngine::RemoveEventObserver(EventObserver* observer)
 {
-  std::unique_lock<std::mutex> lock(callbacksMutex_);
-  auto registered = std::find(observers_.begin(), observers_.end(), observer);
-  assert(registered != observers_.end());
-  observers_.erase(registered);
+  auto isSameObserver = [observer](const RegisteredObserver& registered) {
+    return registered.observer == observer;
+  };
+  bool isRemoved = false;
+  {
+    std::lock_guard<std::mutex> lock(callbacksMutex_);
+    auto registered = std::find_if(observers_.begin(), observers_.end(), isSameObserver);
+    if (registered != observers_.end())
+    {
+      observers_.erase(registered);
+      isRemoved = true;
+    }
+  }
+  if (!isRemoved)
+  {
+    // Deliveries check the registration before each call, see
+    // DeliverQueuedEvents().
+    std::lock_guard<std::mutex> lock(queuedCallbacksMutex_);
+    auto registered =
+        std::find_if(queuedObservers_.begin(), queuedObservers_.end(), isSameObserver);
+    assert(registered != queuedObservers_.end());
+    if (registered != queuedObservers_.end())
+      queuedObservers_.erase(registered);
+  }
+  UpdateObservedEvents();
+}
+
+// static
+IFilterEngine::EventMask
+DefaultFilterEngine::CombineMasks(const std::vector<RegisteredObserver>& observers)
+{
+  EventMask result = 0;
+  for (const auto& registered : observers)
+    result |= registered.mask;
+  return result;
+}
+
+void DefaultFilterEngine::UpdateObservedEvents()
+{
+  std::lock_guard<std::mutex> observedEventsLock(observedEventsMutex_);
+  {
+    std::lock_guard<std::mutex> lock(callbacksMutex_);
+    observedEvents_ = CombineMasks(observers_);
+  }
+  {
+    std::lock_guard<std::mutex> lock(queuedCallbacksMutex_);
+    queuedObservedEvents_ = CombineMasks(queuedObservers_);
+  }
+
+  // lib/filterUpdateRegistration.js checks this object before calling
+  // _triggerEvent, so events nobody listens to don't leave JS.
+  const EventMask mask = observedEvents_ | queuedObservedEvents_;
+  auto observedEvents = jsEngine.NewObject();
+  for (const char* eventName : kEventNames)
+  {
+    FilterEvent filterEvent;
+    SubscriptionEvent subscriptionEvent;
+    if ((Transform(eventName, &filterEvent) && (mask & ToEventMask(filterEvent))) ||
+        (Transform(eventName, &subscriptionEvent) && (mask & ToEventMask(subscriptionEvent))))
+      observedEvents.SetProperty(eventName, true);
+  }
+  jsEngine.SetGlobalProperty("_observedEvents", observedEvents);
 }
 
 void DefaultFilterEngine::SetAllowedConnectionType(const std::string* value)
@@ -228,6 +500,17 @@ void DefaultFilterEngine::SetAllowedConnectionType(const std::string* value)
   SetPref("allowed_connection_type", value ? jsEngine.NewValue(*value) : jsEngine.NewValue(""));
 }
 
+// static
+int DefaultFilterEngine::GetMatchPriority(ContentTypeMask contentTypeMask)
+{
+  // Blocking on these delays rendering of a whole frame.
+  if (contentTypeMask & (CONTENT_TYPE_DOCUMENT | CONTENT_TYPE_SUBDOCUMENT | CONTENT_TYPE_POPUP))
+    return 2;
+  if (contentTypeMask & ~(CONTENT_TYPE_IMAGE | CONTENT_TYPE_MEDIA | CONTENT_TYPE_PING))
+    return 1;
+  return 0;
+}
+
 // static
 bool DefaultFilterEngine::Transform(const std::string& eventStr, FilterEvent* event)
 {
@@ -368,35 +651,148 @@ std::unique_ptr<std::string> DefaultFilterEngine::GetAllowedConnectionType() con
   return std::unique_ptr<std::string>(new std::string(prefValue.AsString()));
 }
 
-void DefaultFilterEngine::OnSubscriptionOrFilterChanged(JsValueList&& params) const
+void DefaultFilterEngine::SetPrefs(const PrefUpdates& prefs)
+{
+  auto prefsObject = jsEngine.NewObject();
+  for (const auto& pref : prefs.booleanPrefs)
+    prefsObject.SetProperty(pref.first, pref.second);
+  for (const auto& pref : prefs.stringPrefs)
+    prefsObject.SetProperty(pref.first, pref.second);
+  for (const auto& pref : prefs.intPrefs)
+    prefsObject.SetProperty(pref.first, pref.second);
+
+  JsValue func = jsEngine.Evaluate("API.setPrefs");
+  func.Call(prefsObject);
+}
+
+void DefaultFilterEngine::OnSubscriptionOrFilterChanged(JsValueList&& params)
 {
   std::string action(params.size() >= 1 && !params[0].IsNull() ? params[0].AsString() : "");
+
+  FilterEvent filterEvent = FilterEvent::FILTERS_LOAD;
+  SubscriptionEvent subscriptionEvent = SubscriptionEvent::SUBSCRIPTION_ADDED;
+  EventMask eventMask = 0;
+  const bool isFilterEvent = Transform(action, &filterEvent);
+  if (isFilterEvent)
+    eventMask = ToEventMask(filterEvent);
+  else if (Transform(action, &subscriptionEvent))
+    eventMask = ToEventMask(subscriptionEvent);
+
+  if (!(eventMask & (observedEvents_ | queuedObservedEvents_)))
+    return;
+
   JsValue item(params.size() >= 2 ? params[1] : jsEngine.NewValue(false));
 
+  if (eventMask & queuedObservedEvents_)
+    QueueEvent({eventMask, isFilterEvent, filterEvent, subscriptionEvent, item});
+
+  if (!(eventMask & observedEvents_))
+    return;
+
   std::unique_lock<std::mutex> lock(callbacksMutex_);
 
-  FilterEvent filterEvent;
-  SubscriptionEvent subscriptionEvent;
-  if (Transform(action, &filterEvent))
+  if (isFilterEvent)
   {
     Filter filter(item.IsObject()
                       ? std::make_unique<DefaultFilterImplementation>(std::move(item), &jsEngine)
                       : nullptr);
-    for (auto* observer : observers_)
+    for (const auto& registered : observers_)
     {
-      observer->OnFilterEvent(filterEvent, filter);
+      if (registered.mask & eventMask)
+        registered.observer->OnFilterEvent(filterEvent, filter);
     }
   }
-  else if (Transform(action, &subscriptionEvent))
+  else
   {
     Subscription subscription(item.IsObject() ? std::make_unique<DefaultSubscriptionImplementation>(
                                                     std::move(item), &jsEngine)
                                               : nullptr);
 
-    for (auto* observer : observers_)
+    for (const auto& registered : observers_)
+    {
+      if (registered.mask & eventMask)
+        registered.observer->OnSubscriptionEvent(subscriptionEvent, subscription);
+    }
+  }
+}
+
+void DefaultFilterEngine::QueueEvent(QueuedEvent&& event)
+{
+  std::lock_guard<std::mutex> lock(eventQueueMutex_);
+  eventQueue_.emplace_back(std::move(event));
+  // Events arriving while a delivery is pending are delivered with it.
+  if (isDeliveryScheduled_ || !eventDispatcher_)
+    return;
+  isDeliveryScheduled_ = true;
+  eventDispatcher_->Post([this] {
+    DeliverQueuedEvents();
+  });
+}
+
+void DefaultFilterEngine::DeliverQueuedEvents()
+{
+  std::vector<QueuedEvent> events;
+  {
+    std::lock_guard<std::mutex> lock(eventQueueMutex_);
+    events.swap(eventQueue_);
+    isDeliveryScheduled_ = false;
+  }
+
+  // Observers are called without holding the lock, so that they can add or
+  // remove observers, and are skipped once they have been removed.
+  std::vector<RegisteredObserver> observers;
+  {
+    std::lock_guard<std::mutex> lock(queuedCallbacksMutex_);
+    observers = queuedObservers_;
+  }
+  auto isRegistered = [this](EventObserver* observer) {
+    std::lock_guard<std::mutex> lock(queuedCallbacksMutex_);
+    return std::any_of(queuedObservers_.begin(),
+                       queuedObservers_.end(),
+                       [observer](const RegisteredObserver& registered) {
+                         return registered.observer == observer;
+                       });
+  };
+
+  // Split the queue into runs of the same event and deliver each run as a
+  // single batch.
+  for (auto runBegin = events.begin(); runBegin != events.end();)
+  {
+    const EventMask eventMask = runBegin->eventMask;
+    auto runEnd = std::find_if(runBegin, events.end(), [eventMask](const QueuedEvent& event) {
+      return event.eventMask != eventMask;
+    });
+
+    if (runBegin->isFilterEvent)
+    {
+      std::vector<Filter> filters;
+      filters.reserve(runEnd - runBegin);
+      for (auto it = runBegin; it != runEnd; ++it)
+        filters.emplace_back(it->item.IsObject() ? std::make_unique<DefaultFilterImplementation>(
+                                                       std::move(it->item), &jsEngine)
+                                                 : nullptr);
+      for (const auto& registered : observers)
+      {
+        if ((registered.mask & eventMask) && isRegistered(registered.observer))
+          registered.observer->OnFilterEvents(runBegin->filterEvent, filters);
+      }
+    }
+    else
     {
-      observer->OnSubscriptionEvent(subscriptionEvent, subscription);
+      std::vector<Subscription> subscriptions;
+      subscriptions.reserve(runEnd - runBegin);
+      for (auto it = runBegin; it != runEnd; ++it)
+        subscriptions.emplace_back(it->item.IsObject()
+                                       ? std::make_unique<DefaultSubscriptionImplementation>(
+                                             std::move(it->item), &jsEngine)
+                                       : nullptr);
+      for (const auto& registered : observers)
+      {
+        if ((registered.mask & eventMask) && isRegistered(registered.observer))
+          registered.observer->OnSubscriptionEvents(runBegin->subscriptionEvent, subscriptions);
+      }
     }
+    runBegin = runEnd;
   }
 }
 
@@ -406,14 +802,7 @@ bool DefaultFilterEngine::VerifySignature(const std::string& key,
                                           const std::string& host,
                                           const std::string& userAgent) const
 {
-  JsValueList params;
-  params.push_back(jsEngine.NewValue(key));
-  params.push_back(jsEngine.NewValue(signature));
-  params.push_back(jsEngine.NewValue(uri));
-  params.push_back(jsEngine.NewValue(host));
-  params.push_back(jsEngine.NewValue(userAgent));
-  JsValue func = jsEngine.Evaluate("API.verifySignature");
-  return func.Call(params).AsBool();
+  return signatureVerifier_.Verify(key, signature, uri, host, userAgent);
 }
 
 std::vector<std::string>
@@ -512,9 +901,33 @@ void DefaultFilterEngine::StopSynchronization()
   func.Call();
 }
 
+void DefaultFilterEngine::StartTraceRecording(size_t maxCalls)
+{
+  traceRecorder_.Start(maxCalls);
+}
+
+void DefaultFilterEngine::StopTraceRecording()
+{
+  traceRecorder_.Stop();
+}
+
+void DefaultFilterEngine::FlushTraceRecording(const std::string& fileName,
+                                              const IFileSystem::Callback& callback)
+{
+  std::string lines = traceRecorder_.Take();
+  if (lines.empty())
+  {
+    callback("");
+    return;
+  }
+  auto stream = jsEngine.GetFileSystem().OpenAppend(fileName);
+  stream->Write(IFileSystem::IOBuffer(lines.begin(), lines.end()), [](const std::string&) {});
+  stream->Close(callback);
+}
+
 void DefaultFilterEngine::StartObservingEvents()
 {
-  AddEventObserver(&observer_);
+  AddEventObserver(&observer_, ToEventMask(FilterEvent::FILTERS_SAVE));
 }
 
 void DefaultFilterEngine::Observer::OnFilterEvent(FilterEvent event, const Filter&)
@@ -533,3 +946,15 @@ std::string AdblockPlus::DefaultFilterEngine::GetSnippetScript(const std::string
   JsValue func = jsEngine.Evaluate("API.getSnippetsScript");
   return func.Call(params).AsString();
 }
+
+void DefaultFilterEngine::SetSnippetLibrary(const std::string& librarySource)
+{
+  JsValue func = jsEngine.Evaluate("API.setSnippetLibrary");
+  func.Call(jsEngine.NewValue(librarySource));
+}
+
+std::string DefaultFilterEngine::GetSnippetScript(const std::string& documentUrl)
+{
+  JsValue func = jsEngine.Evaluate("API.getCachedSnippetsScript");
+  return func.Call(jsEngine.NewValue(documentUrl)).AsString();
+}
@@ -17,10 +17,29 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include <AdblockPlus/IFilterEngine.h>
 
+#include "ActiveObject.h"
+#include "PrioritizedActiveObject.h"
+#include "SignatureVerifier.h"
+#include "TraceRecorder.h"
+
 namespace AdblockPlus
 {
+  class DefaultFrameContext : public IFilterEngine::FrameContext
+  {
+  public:
+    explicit DefaultFrameContext(JsValue&& object) : jsObject(std::move(object))
+    {
+    }
+
+    JsValue jsObject;
+  };
+
   class DefaultFilterEngine : public IFilterEngine
   {
   public:
@@ -35,6 +54,7 @@ namespace AdblockPlus
     std::vector<Filter> GetListedFilters() const final;
 
     std::vector<Subscription> GetListedSubscriptions() const final;
+    std::vector<SubscriptionMemoryUsage> GetSubscriptionMemoryUsage() const final;
 
     std::vector<Subscription> FetchAvailableSubscriptions() const final;
 
@@ -50,24 +70,42 @@ namespace AdblockPlus
                    const std::string& siteKey = "",
                    bool specificOnly = false) const final;
 
+    void MatchesAsync(const MatchRequest& request, const MatchCallback& callback) const final;
+
+    std::future<Filter> MatchesAsync(const MatchRequest& request) const final;
+
     bool IsContentAllowlisted(const std::string& url,
                               ContentTypeMask contentTypeMask,
                               const std::vector<std::string>& documentUrls,
                               const std::string& sitekey = "") const final;
 
+    std::unique_ptr<FrameContext> CreateFrameContext(const std::vector<std::string>& documentUrls,
+                                                     const std::string& sitekey = "") const final;
+
+    Filter Matches(const std::string& url,
+                   ContentTypeMask contentTypeMask,
+                   const FrameContext& frame) const final;
+
+    bool IsContentAllowlisted(ContentTypeMask contentTypeMask,
+                              const FrameContext& frame) const final;
+
     std::string GetElementHidingStyleSheet(const std::string& domain,
                                            bool specificOnly = false) const final;
 
     std::vector<EmulationSelector>
     GetElementHidingEmulationSelectors(const std::string& domain) const final;
 
-    void AddEventObserver(EventObserver* observer) final;
+    void AddEventObserver(EventObserver* observer,
+                          EventMask mask = ALL_EVENTS,
+                          EventDelivery delivery = EventDelivery::SYNCHRONOUS) final;
     void RemoveEventObserver(EventObserver* observer) final;
 
     void SetAllowedConnectionType(const std::string* value) final;
 
     std::unique_ptr<std::string> GetAllowedConnectionType() const final;
 
+    void SetPrefs(const PrefUpdates& prefs) final;
+
     bool VerifySignature(const std::string& key,
                          const std::string& signature,
                          const std::string& uri,
@@ -82,8 +120,14 @@ namespace AdblockPlus
     void RemoveFilter(const Filter& filter) final;
     void StartSynchronization() final;
     void StopSynchronization() final;
+    void StartTraceRecording(size_t maxCalls) final;
+    void StopTraceRecording() final;
+    void FlushTraceRecording(const std::string& fileName,
+                             const IFileSystem::Callback& callback) final;
     std::string GetSnippetScript(const std::string& documentUrl,
                                  const std::string& librarySource) final;
+    void SetSnippetLibrary(const std::string& librarySource) final;
+    std::string GetSnippetScript(const std::string& documentUrl) final;
 
     void StartObservingEvents();
 
@@ -114,16 +158,66 @@ namespace AdblockPlus
                             const std::string& siteKey,
                             bool specificOnly) const;
 
-    void OnSubscriptionOrFilterChanged(JsValueList&& params) const;
+    struct RegisteredObserver
+    {
+      EventObserver* observer;
+      EventMask mask;
+    };
+
+    struct QueuedEvent
+    {
+      EventMask eventMask;
+      bool isFilterEvent;
+      FilterEvent filterEvent;
+      SubscriptionEvent subscriptionEvent;
+      JsValue item;
+    };
+
+    void OnSubscriptionOrFilterChanged(JsValueList&& params);
+    void QueueEvent(QueuedEvent&& event);
+    void DeliverQueuedEvents();
+    void UpdateObservedEvents();
+    static EventMask CombineMasks(const std::vector<RegisteredObserver>& observers);
     Filter GetAllowlistingFilter(const std::string& url,
                                  ContentTypeMask contentTypeMask,
                                  const std::vector<std::string>& documentUrls,
                                  const std::string& sitekey) const;
+    static int GetMatchPriority(ContentTypeMask contentTypeMask);
+    Filter Matches(const MatchRequest& request) const;
+    void PostMatchRequest(const MatchRequest& request, std::function<void()>&& task) const;
     static bool Transform(const std::string& str, FilterEvent* event);
     static bool Transform(const std::string& str, SubscriptionEvent* event);
 
     mutable std::mutex callbacksMutex_;
     Observer observer_{jsEngine};
-    std::vector<IFilterEngine::EventObserver*> observers_;
+    std::vector<RegisteredObserver> observers_;
+
+    // Observers with EventDelivery::QUEUED are called from eventDispatcher_.
+    // Their mutex guards only the list, it isn't held while they are called.
+    std::mutex queuedCallbacksMutex_;
+    std::vector<RegisteredObserver> queuedObservers_;
+
+    // Union of masks of all registered observers, checked on the JS thread
+    // without locking.
+    std::atomic<EventMask> observedEvents_{0};
+    std::atomic<EventMask> queuedObservedEvents_{0};
+    std::mutex observedEventsMutex_;
+
+    std::mutex eventQueueMutex_;
+    std::vector<QueuedEvent> eventQueue_;
+    bool isDeliveryScheduled_ = false;
+    // Created on demand when the first queued observer is added.
+    std::unique_ptr<ActiveObject> eventDispatcher_;
+
+    mutable SignatureVerifier signatureVerifier_;
+
+    mutable std::mutex matchDispatcherMutex_;
+    // Created on demand by the first MatchesAsync() call.
+    mutable std::unique_ptr<PrioritizedActiveObject> matchDispatcher_;
+
+    mutable TraceRecorder traceRecorder_;
+
+    // Set once the first Matches() call is added to the startup timeline.
+    mutable std::atomic<bool> firstMatchRecorded_{false};
   };
 }
@@ -16,14 +16,13 @@
  */
 
 #include <cassert>
+#include <chrono>
 
 #include "DefaultPlatform.h"
 #include "JsEngine.h"
 
 using namespace AdblockPlus;
 
-extern std::string jsSources[];
-
 namespace
 {
   template<typename T>
@@ -51,6 +50,20 @@ DefaultPlatform::DefaultPlatform(PlatformFactory::CreationParameters&& creationP
 
 DefaultPlatform::~DefaultPlatform()
 {
+  // Preferences are written with a delay, pending writes have to start
+  // before the executor is stopped, stopping it waits for them.
+  if (filterEngine_.valid() &&
+      filterEngine_.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+  {
+    try
+    {
+      jsEngine->Evaluate("API.flushPrefs").Call();
+    }
+    catch (const std::exception& e)
+    {
+      GetLogSystem()(LogSystem::LOG_LEVEL_ERROR, e.what(), "DefaultPlatform");
+    }
+  }
   executor->Stop();
 }
 
@@ -62,11 +75,13 @@ JsEngine& DefaultPlatform::GetJsEngine()
 
 void DefaultPlatform::SetUp(const AppInfo& appInfo, std::unique_ptr<IV8IsolateProvider> isolate)
 {
+  // The startup timeline starts here, see GetStartupTimeline().
+  const auto started = std::chrono::steady_clock::now();
   std::lock_guard<std::mutex> lock(modulesMutex_);
   if (jsEngine)
     return;
   JsEngine::Interfaces interfaces{*timer, *fileSystem, *webRequest, *logSystem, *resourceReader};
-  jsEngine = JsEngine::New(appInfo, interfaces, std::move(isolate));
+  jsEngine = JsEngine::New(appInfo, interfaces, std::move(isolate), started);
 }
 
 void DefaultPlatform::CreateFilterEngineAsync(
@@ -126,18 +141,45 @@ IResourceReader& DefaultPlatform::GetResourceReader() const
   return *resourceReader;
 }
 
+StartupTimeline DefaultPlatform::GetStartupTimeline() const
+{
+  std::lock_guard<std::mutex> lock(modulesMutex_);
+  return jsEngine ? jsEngine->GetStartupTimeline() : StartupTimeline();
+}
+
 std::function<void(const std::string&)> DefaultPlatform::GetEvaluateCallback()
 {
   // GetEvaluateCallback() method assumes that jsEngine is already created
   return [this](const std::string& filename) {
-    std::lock_guard<std::mutex> lock(evaluatedJsSourcesMutex_);
-    if (evaluatedJsSources_.find(filename) != evaluatedJsSources_.end())
-      return; // NO-OP, file was already evaluated
+    {
+      std::lock_guard<std::mutex> lock(evaluatedJsSourcesMutex_);
+      if (evaluatedJsSources_.count(filename))
+        return; // NO-OP, file was already evaluated
+      // A script being evaluated may require itself through other modules.
+      if (!evaluatingJsSources_.insert(filename).second)
+        return;
+    }
 
-    for (int i = 0; !jsSources[i].empty(); i += 2)
-      if (jsSources[i] == filename)
+    // The mutex isn't held while evaluating, a script may require a module
+    // which is evaluated on demand. The file only counts as evaluated if
+    // there was no error, otherwise the next require() tries again.
+    for (const JsSource* jsSource = jsSources; jsSource->filename; ++jsSource)
+      if (filename == jsSource->filename)
       {
-        jsEngine->Evaluate(jsSources[i + 1], jsSources[i]);
+        const auto started = std::chrono::steady_clock::now();
+        try
+        {
+          jsEngine->Evaluate(*jsSource);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(evaluatedJsSourcesMutex_);
+          evaluatingJsSources_.erase(filename);
+          throw;
+        }
+        jsEngine->RecordStartupPhase("evaluate:" + filename, started);
+        std::lock_guard<std::mutex> lock(evaluatedJsSourcesMutex_);
+        evaluatingJsSources_.erase(filename);
         evaluatedJsSources_.insert(filename);
         return;
       }
@@ -44,6 +44,7 @@ namespace AdblockPlus
     IWebRequest& GetWebRequest() const override;
     LogSystem& GetLogSystem() const override;
     IResourceReader& GetResourceReader() const override;
+    StartupTimeline GetStartupTimeline() const override;
 
   private:
     std::unique_ptr<JsEngine> jsEngine;
@@ -58,9 +59,10 @@ namespace AdblockPlus
   private:
     std::unique_ptr<IExecutor> executor;
     // used for creation and deletion of modules.
-    std::mutex modulesMutex_;
+    mutable std::mutex modulesMutex_;
     std::shared_future<std::unique_ptr<IFilterEngine>> filterEngine_;
     std::set<std::string> evaluatedJsSources_;
+    std::set<std::string> evaluatingJsSources_;
     std::mutex evaluatedJsSourcesMutex_;
 
     std::function<void(const std::string&)> GetEvaluateCallback();
@@ -110,6 +110,16 @@ int DefaultSubscriptionImplementation::GetVersion() const
   return GetIntProperty("version");
 }
 
+int DefaultSubscriptionImplementation::GetLastUpdateAddedCount() const
+{
+  return jsEngine->Evaluate("API.getLastUpdateAddedCount").Call(jsObject).AsInt();
+}
+
+int DefaultSubscriptionImplementation::GetLastUpdateRemovedCount() const
+{
+  return jsEngine->Evaluate("API.getLastUpdateRemovedCount").Call(jsObject).AsInt();
+}
+
 bool DefaultSubscriptionImplementation::operator==(const ISubscriptionImplementation& value) const
 {
   return GetUrl() == value.GetUrl();
@@ -49,6 +49,8 @@ namespace AdblockPlus
     int GetLastDownloadAttemptTime() const final;
     int GetLastDownloadSuccessTime() const final;
     int GetVersion() const final;
+    int GetLastUpdateAddedCount() const final;
+    int GetLastUpdateRemovedCount() const final;
     bool operator==(const ISubscriptionImplementation& value) const final;
     std::unique_ptr<ISubscriptionImplementation> Clone() const final;
 
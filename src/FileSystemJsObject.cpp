@@ -76,22 +76,13 @@ namespace
       return c == 10 || c == 13;
     }
 
-    inline StringBuffer::const_iterator SkipEndOfLine(StringBuffer::const_iterator ii,
-                                                      StringBuffer::const_iterator end)
+    inline const char* SkipEndOfLine(const char* ii, const char* end)
     {
       while (ii != end && IsEndOfLine(*ii))
         ++ii;
       return ii;
     }
 
-    inline StringBuffer::const_iterator AdvanceToEndOfLine(StringBuffer::const_iterator ii,
-                                                           StringBuffer::const_iterator end)
-    {
-      while (ii != end && !IsEndOfLine(*ii))
-        ++ii;
-      return ii;
-    }
-
     void V8Callback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
     {
       AdblockPlus::JsEngine* jsEngine = AdblockPlus::JsEngine::FromArguments(arguments);
@@ -130,18 +121,20 @@ namespace
 
             auto isolate = jsEngine->GetIsolate();
             const v8::TryCatch tryCatch(isolate);
-            const auto contentEnd = content.cend();
-            auto stringBegin = SkipEndOfLine(content.begin(), contentEnd);
+            const char* contentBegin = reinterpret_cast<const char*>(content.data());
+            const char* contentEnd = contentBegin + content.size();
+            auto stringBegin = SkipEndOfLine(contentBegin, contentEnd);
             auto v8Context = isolate->GetCurrentContext();
             do
             {
-              auto stringEnd = AdvanceToEndOfLine(stringBegin, contentEnd);
-              auto jsLine =
-                  CHECKED_TO_LOCAL_WITH_TRY_CATCH(
-                      isolate,
-                      Utils::StringBufferToV8String(isolate, StringBuffer(stringBegin, stringEnd)),
-                      tryCatch)
-                      .As<v8::Value>();
+              bool isAscii = true;
+              auto stringEnd = Utils::FindLineBreak(stringBegin, contentEnd, &isAscii);
+              auto jsLine = CHECKED_TO_LOCAL_WITH_TRY_CATCH(
+                                isolate,
+                                Utils::ToV8String(
+                                    isolate, stringBegin, stringEnd - stringBegin, isAscii),
+                                tryCatch)
+                                .As<v8::Value>();
 
               CHECKED_TO_LOCAL_WITH_TRY_CATCH(
                   isolate, processFunc->Call(v8Context, globalContext, 1, &jsLine), tryCatch);
@@ -182,6 +175,84 @@ namespace
         });
   }
 
+  void OpenWriteCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
+  {
+    AdblockPlus::JsEngine* jsEngine = AdblockPlus::JsEngine::FromArguments(arguments);
+    AdblockPlus::JsValueList converted = jsEngine->ConvertArguments(arguments);
+
+    v8::Isolate* isolate = arguments.GetIsolate();
+    if (converted.size() != 1)
+      return ThrowExceptionInJS(isolate, "_fileSystem.openWrite requires 1 parameter");
+
+    auto stream = jsEngine->GetFileSystem().OpenWrite(converted[0].AsString());
+    int id = jsEngine->StoreWriteStream(std::move(stream));
+    arguments.GetReturnValue().Set(id);
+  }
+
+  void OpenAppendCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
+  {
+    AdblockPlus::JsEngine* jsEngine = AdblockPlus::JsEngine::FromArguments(arguments);
+    AdblockPlus::JsValueList converted = jsEngine->ConvertArguments(arguments);
+
+    v8::Isolate* isolate = arguments.GetIsolate();
+    if (converted.size() != 1)
+      return ThrowExceptionInJS(isolate, "_fileSystem.openAppend requires 1 parameter");
+
+    auto stream = jsEngine->GetFileSystem().OpenAppend(converted[0].AsString());
+    int id = jsEngine->StoreWriteStream(std::move(stream));
+    arguments.GetReturnValue().Set(id);
+  }
+
+  void WriteChunkCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
+  {
+    AdblockPlus::JsEngine* jsEngine = AdblockPlus::JsEngine::FromArguments(arguments);
+    AdblockPlus::JsValueList converted = jsEngine->ConvertArguments(arguments);
+
+    v8::Isolate* isolate = arguments.GetIsolate();
+    if (converted.size() != 3)
+      return ThrowExceptionInJS(isolate, "_fileSystem.writeChunk requires 3 parameters");
+    if (!converted[2].IsFunction())
+      return ThrowExceptionInJS(isolate,
+                                "Third argument to _fileSystem.writeChunk must be a function");
+    auto stream = jsEngine->GetWriteStream(static_cast<int>(converted[0].AsInt()));
+    if (!stream)
+      return ThrowExceptionInJS(isolate, "_fileSystem.writeChunk called for a closed file");
+
+    JsEngine::ScopedWeakValues weakCallbackValue(jsEngine, {converted[2]});
+    stream->Write(converted[1].AsStringBuffer(),
+                  [jsEngine, weakCallbackValue](const std::string& error) {
+                    const JsContext context(jsEngine->GetIsolate(), *jsEngine->GetContext());
+                    JsValueList params;
+                    if (!error.empty())
+                      params.push_back(jsEngine->NewValue(error));
+                    weakCallbackValue.Values()[0].Call(params);
+                  });
+  }
+
+  void CloseCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
+  {
+    AdblockPlus::JsEngine* jsEngine = AdblockPlus::JsEngine::FromArguments(arguments);
+    AdblockPlus::JsValueList converted = jsEngine->ConvertArguments(arguments);
+
+    v8::Isolate* isolate = arguments.GetIsolate();
+    if (converted.size() != 2)
+      return ThrowExceptionInJS(isolate, "_fileSystem.close requires 2 parameters");
+    if (!converted[1].IsFunction())
+      return ThrowExceptionInJS(isolate, "Second argument to _fileSystem.close must be a function");
+    auto stream = jsEngine->TakeWriteStream(static_cast<int>(converted[0].AsInt()));
+    if (!stream)
+      return ThrowExceptionInJS(isolate, "_fileSystem.close called for a closed file");
+
+    JsEngine::ScopedWeakValues weakCallbackValue(jsEngine, {converted[1]});
+    stream->Close([jsEngine, weakCallbackValue](const std::string& error) {
+      const JsContext context(jsEngine->GetIsolate(), *jsEngine->GetContext());
+      JsValueList params;
+      if (!error.empty())
+        params.push_back(jsEngine->NewValue(error));
+      weakCallbackValue.Values()[0].Call(params);
+    });
+  }
+
   void MoveCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
   {
     AdblockPlus::JsEngine* jsEngine = AdblockPlus::JsEngine::FromArguments(arguments);
@@ -267,6 +338,10 @@ JsValue& FileSystemJsObject::Setup(JsEngine& jsEngine, JsValue& obj)
   obj.SetProperty("read", jsEngine.NewCallback(::ReadCallback::V8Callback));
   obj.SetProperty("readFromFile", jsEngine.NewCallback(::ReadFromFileCallback::V8Callback));
   obj.SetProperty("write", jsEngine.NewCallback(::WriteCallback));
+  obj.SetProperty("openWrite", jsEngine.NewCallback(::OpenWriteCallback));
+  obj.SetProperty("openAppend", jsEngine.NewCallback(::OpenAppendCallback));
+  obj.SetProperty("writeChunk", jsEngine.NewCallback(::WriteChunkCallback));
+  obj.SetProperty("close", jsEngine.NewCallback(::CloseCallback));
   obj.SetProperty("move", jsEngine.NewCallback(::MoveCallback));
   obj.SetProperty("remove", jsEngine.NewCallback(::RemoveCallback));
   obj.SetProperty("stat", jsEngine.NewCallback(::StatCallback));
@@ -17,7 +17,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <functional>
+#include <map>
+#include <memory>
 #include <string>
 
 #include <AdblockPlus/FilterEngineFactory.h>
@@ -29,6 +32,22 @@
 
 using namespace AdblockPlus;
 
+namespace
+{
+  // Modules which most sessions never use, they are evaluated the first time
+  // they are required. See require() in lib/compat.js. snippets.js and
+  // analytics.js would qualify too, but adblockpluscore requires them when
+  // downloader.js and filterListener.js are evaluated.
+  constexpr const char* lazyJsFiles[] = {
+      "compose.js", "jsbn.js", "rusha.js", "rsa.js", "recommendations.js"};
+
+  bool IsLazyJsFile(const std::string& filename)
+  {
+    return std::find(std::begin(lazyJsFiles), std::end(lazyJsFiles), filename) !=
+           std::end(lazyJsFiles);
+  }
+}
+
 // static
 std::string FilterEngineFactory::PrefNameToString(BooleanPrefName prefName)
 {
@@ -144,13 +163,50 @@ void FilterEngineFactory::CreateAsync(JsEngine& jsEngine,
         });
   }
 
-  jsEngine.SetEventCallback("_init",
-                            [&jsEngine, wrappedFilterEngine, onCreated](JsValueList&& params) {
-                              auto uniqueFilterEngine = std::move(*wrappedFilterEngine);
-                              onCreated(std::move(uniqueFilterEngine));
-                              jsEngine.RemoveEventCallback("_init");
+  // lib/init.js reports the start and the end of its startup phases.
+  auto startupPhaseStarts =
+      std::make_shared<std::map<std::string, std::chrono::steady_clock::time_point>>();
+  jsEngine.SetEventCallback("_startupPhase",
+                            [&jsEngine, startupPhaseStarts](JsValueList&& params) {
+                              // param[0] - phase name
+                              // param[1] - true if the phase has finished
+                              if (params.size() != 2)
+                                return;
+                              const std::string name = params[0].AsString();
+                              if (!params[1].AsBool())
+                                (*startupPhaseStarts)[name] = std::chrono::steady_clock::now();
+                              else if (startupPhaseStarts->count(name))
+                                jsEngine.RecordStartupPhase(name, (*startupPhaseStarts)[name]);
                             });
 
+  const auto creationStarted = std::chrono::steady_clock::now();
+  jsEngine.SetEventCallback(
+      "_init", [&jsEngine, wrappedFilterEngine, onCreated, creationStarted](JsValueList&& params) {
+        jsEngine.RecordStartupPhase("_init", creationStarted);
+        jsEngine.RemoveEventCallback("_startupPhase");
+        auto uniqueFilterEngine = std::move(*wrappedFilterEngine);
+        onCreated(std::move(uniqueFilterEngine));
+        jsEngine.RemoveEventCallback("_init");
+      });
+
+  jsEngine.SetEventCallback("_requireModule", [&jsEngine, evaluateCallback](JsValueList&& params) {
+    // param[0] - module name
+    if (params.size() != 1 || !params[0].IsString())
+      return;
+    const std::string jsFile = params[0].AsString() + ".js";
+    if (!IsLazyJsFile(jsFile))
+      return;
+    // Called from require() in JS, errors are passed on to it.
+    try
+    {
+      evaluateCallback(jsFile);
+    }
+    catch (const std::exception& e)
+    {
+      Utils::ThrowExceptionInJS(jsEngine.GetIsolate(), e.what());
+    }
+  });
+
   bareFilterEngine->StartObservingEvents();
 
   // Lock the JS engine while we are loading scripts, no timeouts should fire
@@ -174,6 +230,7 @@ void FilterEngineFactory::CreateAsync(JsEngine& jsEngine,
   for (const auto& filterEngineJsFile : jsFiles)
   {
     auto filepathComponents = Utils::SplitString(filterEngineJsFile, '/');
-    evaluateCallback(filepathComponents.back());
+    if (!IsLazyJsFile(filepathComponents.back()))
+      evaluateCallback(filepathComponents.back());
   }
 }
@@ -0,0 +1,277 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "FilterListPreparser.h"
+
+#include <array>
+#include <cctype>
+#include <cstdint>
+
+#include "Utils.h"
+
+using namespace AdblockPlus;
+
+namespace
+{
+  bool IsLineBreak(char c)
+  {
+    return c == '\n' || c == '\r';
+  }
+
+  bool IsWhitespace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\v' || c == '\f' || IsLineBreak(c);
+  }
+
+  bool IsChecksumChar(char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == '+' || c == '/' || c == '=';
+  }
+
+  bool StartsWithIgnoreCase(const char* begin, const char* end, const char* prefix)
+  {
+    for (; *prefix; ++begin, ++prefix)
+    {
+      if (begin == end || std::tolower(static_cast<unsigned char>(*begin)) != *prefix)
+        return false;
+    }
+    return true;
+  }
+
+  // Matches /^\s*!\s*checksum[\s\-:]+([\w\+\/=]+)/i
+  bool ParseChecksumLine(const char* begin, const char* end, std::string* value)
+  {
+    while (begin != end && IsWhitespace(*begin))
+      ++begin;
+    if (begin == end || *begin++ != '!')
+      return false;
+    while (begin != end && IsWhitespace(*begin))
+      ++begin;
+    if (!StartsWithIgnoreCase(begin, end, "checksum"))
+      return false;
+    begin += 8;
+    const char* separatorBegin = begin;
+    while (begin != end && (IsWhitespace(*begin) || *begin == '-' || *begin == ':'))
+      ++begin;
+    const char* valueBegin = begin;
+    while (begin != end && IsChecksumChar(*begin))
+      ++begin;
+    if (separatorBegin == valueBegin || valueBegin == begin)
+      return false;
+    if (value)
+      value->assign(valueBegin, begin);
+    return true;
+  }
+
+  class Md5
+  {
+  public:
+    Md5() : length(0), state{0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476}
+    {
+    }
+
+    void Update(const char* data, size_t size)
+    {
+      for (size_t i = 0; i < size; ++i)
+      {
+        block[length++ % 64] = static_cast<uint8_t>(data[i]);
+        if (length % 64 == 0)
+          Transform();
+      }
+    }
+
+    std::array<uint8_t, 16> Finish()
+    {
+      uint64_t bitLength = length * 8;
+      const char padding = '\x80';
+      Update(&padding, 1);
+      while (length % 64 != 56)
+      {
+        const char zero = 0;
+        Update(&zero, 1);
+      }
+      for (int i = 0; i < 8; ++i)
+      {
+        char byte = static_cast<char>(bitLength >> (8 * i));
+        Update(&byte, 1);
+      }
+
+      std::array<uint8_t, 16> digest;
+      for (int i = 0; i < 16; ++i)
+        digest[i] = static_cast<uint8_t>(state[i / 4] >> (8 * (i % 4)));
+      return digest;
+    }
+
+  private:
+    static uint32_t RotateLeft(uint32_t value, int bits)
+    {
+      return (value << bits) | (value >> (32 - bits));
+    }
+
+    void Transform()
+    {
+      static const uint32_t k[64] = {
+          0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613,
+          0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193,
+          0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d,
+          0x02441453, 0xd8a1e681, 0xe7d3fbc8, 0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+          0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122,
+          0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+          0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665, 0xf4292244,
+          0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+          0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb,
+          0xeb86d391};
+      static const int shifts[64] = {7,  12, 17, 22, 7,  12, 17, 22, 7,  12, 17, 22, 7,
+                                     12, 17, 22, 5,  9,  14, 20, 5,  9,  14, 20, 5,  9,
+                                     14, 20, 5,  9,  14, 20, 4,  11, 16, 23, 4,  11, 16,
+                                     23, 4,  11, 16, 23, 4,  11, 16, 23, 6,  10, 15, 21,
+                                     6,  10, 15, 21, 6,  10, 15, 21, 6,  10, 15, 21};
+
+      uint32_t words[16];
+      for (int i = 0; i < 16; ++i)
+      {
+        words[i] = block[i * 4] | (block[i * 4 + 1] << 8) | (block[i * 4 + 2] << 16) |
+                   (static_cast<uint32_t>(block[i * 4 + 3]) << 24);
+      }
+
+      uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+      for (int i = 0; i < 64; ++i)
+      {
+        uint32_t f;
+        int g;
+        if (i < 16)
+        {
+          f = (b & c) | (~b & d);
+          g = i;
+        }
+        else if (i < 32)
+        {
+          f = (d & b) | (~d & c);
+          g = (5 * i + 1) % 16;
+        }
+        else if (i < 48)
+        {
+          f = b ^ c ^ d;
+          g = (3 * i + 5) % 16;
+        }
+        else
+        {
+          f = c ^ (b | ~d);
+          g = (7 * i) % 16;
+        }
+        uint32_t next = d;
+        d = c;
+        c = b;
+        b += RotateLeft(a + f + k[i] + words[g], shifts[i]);
+        a = next;
+      }
+      state[0] += a;
+      state[1] += b;
+      state[2] += c;
+      state[3] += d;
+    }
+
+    uint64_t length;
+    uint32_t state[4];
+    uint8_t block[64];
+  };
+
+  std::string Base64EncodeWithoutPadding(const uint8_t* data, size_t size)
+  {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string result;
+    for (size_t i = 0; i < size; i += 3)
+    {
+      uint32_t chunk = data[i] << 16;
+      if (i + 1 < size)
+        chunk |= data[i + 1] << 8;
+      if (i + 2 < size)
+        chunk |= data[i + 2];
+      result.push_back(alphabet[(chunk >> 18) & 0x3f]);
+      result.push_back(alphabet[(chunk >> 12) & 0x3f]);
+      if (i + 1 < size)
+        result.push_back(alphabet[(chunk >> 6) & 0x3f]);
+      if (i + 2 < size)
+        result.push_back(alphabet[chunk & 0x3f]);
+    }
+    return result;
+  }
+}
+
+// static
+FilterListPreparser::Checksum FilterListPreparser::VerifyChecksum(const std::string& text)
+{
+  const char* position = text.data();
+  const char* end = position + text.size();
+  const char* headerEnd = Utils::FindLineBreak(position, end);
+  bool hasHeader = false;
+  for (const char* c = position; c != headerEnd && !hasHeader; ++c)
+    hasHeader = StartsWithIgnoreCase(c, headerEnd, "[adblock");
+  if (!hasHeader)
+    return Checksum::NONE;
+
+  std::string expectedChecksum;
+  for (position = headerEnd; position != end && expectedChecksum.empty();)
+  {
+    while (position != end && IsLineBreak(*position))
+      ++position;
+    const char* lineBegin = position;
+    position = Utils::FindLineBreak(position, end);
+    ParseChecksumLine(lineBegin, position, &expectedChecksum);
+  }
+
+  if (expectedChecksum.empty())
+    return Checksum::NONE;
+  if (CalculateChecksum(text) != expectedChecksum)
+    return Checksum::MISMATCH;
+  return Checksum::VALID;
+}
+
+// static
+std::string FilterListPreparser::CalculateChecksum(const std::string& text)
+{
+  // Drop carriage returns and collapse line breaks first.
+  std::string data;
+  data.reserve(text.size());
+  for (char c : text)
+  {
+    if (c == '\r' || (c == '\n' && !data.empty() && data.back() == '\n'))
+      continue;
+    data.push_back(c);
+  }
+
+  Md5 md5;
+  for (size_t lineBegin = 0; lineBegin < data.size();)
+  {
+    size_t lineEnd = data.find('\n', lineBegin);
+    if (lineEnd == std::string::npos)
+      lineEnd = data.size();
+    else
+      ++lineEnd;
+
+    bool skip = data[lineEnd - 1] == '\n' &&
+                ParseChecksumLine(data.data() + lineBegin, data.data() + lineEnd - 1, nullptr);
+    if (!skip)
+      md5.Update(data.data() + lineBegin, lineEnd - lineBegin);
+    lineBegin = lineEnd;
+  }
+
+  std::array<uint8_t, 16> digest = md5.Finish();
+  return Base64EncodeWithoutPadding(digest.data(), digest.size());
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+
+namespace AdblockPlus
+{
+  /**
+   * Does the filter list processing which doesn't need the JS engine, which
+   * is checking the "! Checksum:" header. It's meant to run on the thread
+   * delivering the download, the list itself is passed to the engine
+   * unchanged.
+   */
+  class FilterListPreparser
+  {
+  public:
+    enum class Checksum
+    {
+      NONE,
+      VALID,
+      MISMATCH
+    };
+
+    /**
+     * Compares the "! Checksum:" header of a filter list with its contents.
+     * @param text Contents of the downloaded file.
+     * @return `Checksum::NONE` if `text` doesn't start with an "[Adblock"
+     *         header or has no checksum.
+     */
+    static Checksum VerifyChecksum(const std::string& text);
+
+    /**
+     * Calculates the checksum of a filter list the way the "! Checksum:"
+     * header is generated: MD5 of the list without the checksum line, carriage
+     * returns and empty lines, encoded as base64 without padding.
+     */
+    static std::string CalculateChecksum(const std::string& text);
+  };
+}
@@ -0,0 +1,100 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <AdblockPlus/IFileSystem.h>
+
+#include <memory>
+
+using namespace AdblockPlus;
+
+namespace
+{
+  class BufferedWriteStream : public IFileSystem::WriteStream
+  {
+  public:
+    BufferedWriteStream(IFileSystem& fileSystem, const std::string& fileName)
+        : fileSystem(fileSystem), fileName(fileName)
+    {
+    }
+
+    void Write(IFileSystem::IOBuffer&& data, const IFileSystem::Callback& callback) override
+    {
+      if (buffer.empty())
+        buffer = std::move(data);
+      else
+        buffer.insert(buffer.end(), data.begin(), data.end());
+      callback("");
+    }
+
+    void Close(const IFileSystem::Callback& callback) override
+    {
+      fileSystem.Write(fileName, buffer, callback);
+      buffer.clear();
+    }
+
+  protected:
+    IFileSystem& fileSystem;
+    std::string fileName;
+    IFileSystem::IOBuffer buffer;
+  };
+
+  class BufferedAppendStream : public BufferedWriteStream
+  {
+  public:
+    using BufferedWriteStream::BufferedWriteStream;
+
+    void Close(const IFileSystem::Callback& callback) override
+    {
+      // The stream is usually gone by the time the file is read.
+      auto appended = std::make_shared<IFileSystem::IOBuffer>(std::move(buffer));
+      IFileSystem* fileSystem = &this->fileSystem;
+      std::string fileName = this->fileName;
+      fileSystem->Stat(
+          fileName,
+          [fileSystem, fileName, appended, callback](const IFileSystem::StatResult& result,
+                                                     const std::string& error) {
+            if (!error.empty())
+            {
+              callback(error);
+              return;
+            }
+            if (!result.exists)
+            {
+              fileSystem->Write(fileName, *appended, callback);
+              return;
+            }
+            fileSystem->Read(
+                fileName,
+                [fileSystem, fileName, appended, callback](IFileSystem::IOBuffer&& content) {
+                  content.insert(content.end(), appended->begin(), appended->end());
+                  fileSystem->Write(fileName, content, callback);
+                },
+                callback);
+          });
+    }
+  };
+}
+
+std::unique_ptr<IFileSystem::WriteStream> IFileSystem::OpenWrite(const std::string& fileName)
+{
+  return std::unique_ptr<WriteStream>(new BufferedWriteStream(*this, fileName));
+}
+
+std::unique_ptr<IFileSystem::WriteStream> IFileSystem::OpenAppend(const std::string& fileName)
+{
+  return std::unique_ptr<WriteStream>(new BufferedAppendStream(*this, fileName));
+}
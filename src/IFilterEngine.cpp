@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <exception>
 #include <map>
+#include <memory>
 
 #include <AdblockPlus/IFilterEngine.h>
 
@@ -75,3 +76,25 @@ IFilterEngine::ContentType IFilterEngine::StringToContentType(const std::string&
   }
   throw std::invalid_argument("Cannot convert argument to ContentType");
 }
+
+IFilterEngine::EventMask IFilterEngine::ToEventMask(FilterEvent event)
+{
+  return 1u << static_cast<unsigned>(event);
+}
+
+IFilterEngine::EventMask IFilterEngine::ToEventMask(SubscriptionEvent event)
+{
+  // Subscription events follow filter events in the mask.
+  const unsigned filterEventCount = static_cast<unsigned>(FilterEvent::FILTER_LASTHIT) + 1;
+  return 1u << (filterEventCount + static_cast<unsigned>(event));
+}
+
+std::future<Filter> IFilterEngine::MatchesAsync(const MatchRequest& request) const
+{
+  auto promise = std::make_shared<std::promise<Filter>>();
+  auto result = promise->get_future();
+  MatchesAsync(request, [promise](const Filter& filter) {
+    promise->set_value(filter);
+  });
+  return result;
+}
@@ -31,11 +31,75 @@
 
 namespace
 {
-  v8::MaybeLocal<v8::Script>
-  CompileScript(v8::Isolate* isolate, const std::string& source, const std::string& filename)
+  /**
+   * Exposes the buffer of a preloaded filter list to V8 without copying,
+   * V8 disposes the resource when the string is garbage collected.
+   */
+  class PreloadedFilterListResource : public v8::String::ExternalOneByteStringResource
+  {
+  public:
+    explicit PreloadedFilterListResource(
+        std::unique_ptr<AdblockPlus::IPreloadedFilterResponse> response)
+        : response(std::move(response))
+    {
+    }
+
+    const char* data() const override
+    {
+      return response->content();
+    }
+
+    size_t length() const override
+    {
+      return response->size();
+    }
+
+    std::unique_ptr<AdblockPlus::IPreloadedFilterResponse> response;
+  };
+
+  /**
+   * Exposes a script embedded by convert_js.py to V8 without copying, the
+   * bytes are in read-only data and are never freed.
+   */
+  class JsSourceResource : public v8::String::ExternalOneByteStringResource
+  {
+  public:
+    explicit JsSourceResource(const AdblockPlus::JsSource& jsSource) : jsSource(jsSource)
+    {
+    }
+
+    const char* data() const override
+    {
+      return jsSource.source;
+    }
+
+    size_t length() const override
+    {
+      return jsSource.sourceLength;
+    }
+
+  private:
+    AdblockPlus::JsSource jsSource;
+  };
+
+  v8::MaybeLocal<v8::String> NewJsSourceString(v8::Isolate* isolate,
+                                               const AdblockPlus::JsSource& jsSource)
+  {
+    auto resource = new JsSourceResource(jsSource);
+    auto value = v8::String::NewExternalOneByte(isolate, resource);
+    if (!value.IsEmpty())
+      return value;
+    // V8 doesn't take the ownership of the resource if it fails.
+    delete resource;
+    return AdblockPlus::Utils::ToV8String(
+        isolate, std::string(jsSource.source, jsSource.sourceLength));
+  }
+
+  v8::MaybeLocal<v8::Script> CompileScript(v8::Isolate* isolate,
+                                           v8::MaybeLocal<v8::String> maybeV8Source,
+                                           const std::string& filename)
   {
     using AdblockPlus::Utils::ToV8String;
-    auto maybeV8Source = ToV8String(isolate, source);
     if (maybeV8Source.IsEmpty())
       return v8::MaybeLocal<v8::Script>();
     const v8::Local<v8::String> v8Source = maybeV8Source.ToLocalChecked();
@@ -53,8 +117,9 @@ namespace
 
   class V8Initializer
   {
-    V8Initializer() : platform{nullptr}
+    explicit V8Initializer(bool& initialized) : platform{nullptr}
     {
+      initialized = true;
       std::string cmd = "--use_strict";
       v8::V8::SetFlagsFromString(cmd.c_str(), cmd.length());
       platform = v8::platform::NewDefaultPlatform();
@@ -70,11 +135,14 @@ namespace
     std::unique_ptr<v8::Platform> platform;
 
   public:
-    static void Init()
+    // Returns true if V8 was initialized by this call.
+    static bool Init()
     {
       // it's threadsafe since C++11 and it will be instantiated only once and
       // destroyed at the application exit
-      static V8Initializer initializer;
+      bool initialized = false;
+      static V8Initializer initializer(initialized);
+      return initialized;
     }
   };
 
@@ -126,6 +194,65 @@ void JsEngine::NotifyLowMemory()
   GetIsolate()->MemoryPressureNotification(v8::MemoryPressureLevel::kCritical);
 }
 
+void JsEngine::BeginForegroundWork()
+{
+  ++pendingForegroundWork_;
+}
+
+void JsEngine::EndForegroundWork()
+{
+  --pendingForegroundWork_;
+}
+
+void JsEngine::RunBackgroundTask(std::function<void()>&& task)
+{
+  if (pendingForegroundWork_ == 0)
+  {
+    task();
+    return;
+  }
+  const auto maxDelay = std::chrono::milliseconds(10);
+  RunOrDeferBackgroundTask(std::make_shared<std::function<void()>>(std::move(task)),
+                           std::chrono::steady_clock::now() + maxDelay);
+}
+
+void JsEngine::RunOrDeferBackgroundTask(const std::shared_ptr<std::function<void()>>& task,
+                                        std::chrono::steady_clock::time_point deadline)
+{
+  if (pendingForegroundWork_ == 0 || std::chrono::steady_clock::now() >= deadline)
+  {
+    (*task)();
+    return;
+  }
+  // Checked again after the tasks already due on the timer thread.
+  GetTimer().SetTimer(std::chrono::milliseconds(1),
+                      [this, task, deadline] { RunOrDeferBackgroundTask(task, deadline); });
+}
+
+int JsEngine::StoreWriteStream(std::unique_ptr<IFileSystem::WriteStream> stream)
+{
+  writeStreams_[++lastWriteStreamId_] = std::move(stream);
+  return lastWriteStreamId_;
+}
+
+IFileSystem::WriteStream* JsEngine::GetWriteStream(int id) const
+{
+  auto it = writeStreams_.find(id);
+  return it == writeStreams_.end() ? nullptr : it->second.get();
+}
+
+std::unique_ptr<IFileSystem::WriteStream> JsEngine::TakeWriteStream(int id)
+{
+  std::unique_ptr<IFileSystem::WriteStream> result;
+  auto it = writeStreams_.find(id);
+  if (it != writeStreams_.end())
+  {
+    result = std::move(it->second);
+    writeStreams_.erase(it);
+  }
+  return result;
+}
+
 void JsEngine::ScheduleTimer(const v8::FunctionCallbackInfo<v8::Value>& arguments)
 {
   auto jsEngine = FromArguments(arguments);
@@ -142,7 +269,8 @@ void JsEngine::ScheduleTimer(const v8::FunctionCallbackInfo<v8::Value>& argument
       CHECKED_TO_VALUE(arguments[1]->IntegerValue(arguments.GetIsolate()->GetCurrentContext()));
 
   jsEngine->GetTimer().SetTimer(std::chrono::milliseconds(millis), [jsEngine, timerParamsID] {
-    jsEngine->CallTimerTask(timerParamsID);
+    jsEngine->RunBackgroundTask(
+        [jsEngine, timerParamsID] { jsEngine->CallTimerTask(timerParamsID); });
   });
 }
 
@@ -180,13 +308,19 @@ JsEngine::~JsEngine()
 std::unique_ptr<AdblockPlus::JsEngine>
 AdblockPlus::JsEngine::New(const AppInfo& appInfo,
                            const Interfaces& interfaces,
-                           std::unique_ptr<IV8IsolateProvider> isolate)
+                           std::unique_ptr<IV8IsolateProvider> isolate,
+                           std::chrono::steady_clock::time_point startupStart)
 {
+  // V8 is only initialized by the first engine of the process.
+  const auto v8InitStarted = std::chrono::steady_clock::now();
+  const bool initializedV8 = !isolate && V8Initializer::Init();
+  const auto started = std::chrono::steady_clock::now();
   if (!isolate)
-  {
     isolate.reset(new ScopedV8Isolate());
-  }
   std::unique_ptr<AdblockPlus::JsEngine> result(new JsEngine(interfaces, std::move(isolate)));
+  result->startupStart_ = startupStart;
+  if (initializedV8)
+    result->RecordStartupPhase("V8Initializer::Init", v8InitStarted, started);
 
   const v8::Locker locker(result->GetIsolate());
   const v8::Isolate::Scope isolateScope(result->GetIsolate());
@@ -196,6 +330,7 @@ AdblockPlus::JsEngine::New(const AppInfo& appInfo,
       v8::Global<v8::Context>(result->GetIsolate(), v8::Context::New(result->GetIsolate()));
   auto global = result->GetGlobalObject();
   AdblockPlus::GlobalJsObject::Setup(*result, appInfo, global);
+  result->RecordStartupPhase("JsEngine::New", started);
   return result;
 }
 
@@ -211,8 +346,22 @@ AdblockPlus::JsValue AdblockPlus::JsEngine::Evaluate(const std::string& source,
   auto isolate = GetIsolate();
   const JsContext context(isolate, *GetContext());
   const v8::TryCatch tryCatch(isolate);
-  auto script =
-      CHECKED_TO_LOCAL_WITH_TRY_CATCH(isolate, CompileScript(isolate, source, filename), tryCatch);
+  auto script = CHECKED_TO_LOCAL_WITH_TRY_CATCH(
+      isolate, CompileScript(isolate, Utils::ToV8String(isolate, source), filename), tryCatch);
+  auto result =
+      CHECKED_TO_LOCAL_WITH_TRY_CATCH(isolate, script->Run(isolate->GetCurrentContext()), tryCatch);
+  return JsValue(GetIsolateProviderPtr(), GetContext(), result);
+}
+
+AdblockPlus::JsValue AdblockPlus::JsEngine::Evaluate(const JsSource& jsSource)
+{
+  auto isolate = GetIsolate();
+  const JsContext context(isolate, *GetContext());
+  const v8::TryCatch tryCatch(isolate);
+  auto script = CHECKED_TO_LOCAL_WITH_TRY_CATCH(
+      isolate,
+      CompileScript(isolate, NewJsSourceString(isolate, jsSource), jsSource.filename),
+      tryCatch);
   auto result =
       CHECKED_TO_LOCAL_WITH_TRY_CATCH(isolate, script->Run(isolate->GetCurrentContext()), tryCatch);
   return JsValue(GetIsolateProviderPtr(), GetContext(), result);
@@ -250,6 +399,24 @@ void AdblockPlus::JsEngine::TriggerEvent(const std::string& eventName,
   callback(move(params));
 }
 
+void AdblockPlus::JsEngine::RecordStartupPhase(const std::string& name,
+                                               std::chrono::steady_clock::time_point start,
+                                               std::chrono::steady_clock::time_point end)
+{
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  std::lock_guard<std::mutex> lock(startupTimelineMutex_);
+  startupTimeline_.push_back(StartupPhase{name,
+                                          duration_cast<microseconds>(start - startupStart_),
+                                          duration_cast<microseconds>(end - start)});
+}
+
+AdblockPlus::StartupTimeline AdblockPlus::JsEngine::GetStartupTimeline() const
+{
+  std::lock_guard<std::mutex> lock(startupTimelineMutex_);
+  return startupTimeline_;
+}
+
 void AdblockPlus::JsEngine::Gc()
 {
   while (!GetIsolate()->IdleNotificationDeadline(10))
@@ -266,6 +433,32 @@ AdblockPlus::JsValue AdblockPlus::JsEngine::NewValue(const std::string& val)
                  CHECKED_TO_LOCAL(isolate, Utils::ToV8String(isolate, val)));
 }
 
+AdblockPlus::JsValue
+AdblockPlus::JsEngine::NewValue(std::unique_ptr<IPreloadedFilterResponse> response)
+{
+  auto isolate = GetIsolate();
+  const JsContext context(isolate, *GetContext());
+
+  if (response->size() > 0 && Utils::IsAscii(response->content(), response->size()))
+  {
+    auto resource = new PreloadedFilterListResource(std::move(response));
+    auto value = v8::String::NewExternalOneByte(isolate, resource);
+    if (!value.IsEmpty())
+      return JsValue(GetIsolateProviderPtr(), GetContext(), value.ToLocalChecked());
+    // V8 doesn't take the ownership of the resource if it fails.
+    response = std::move(resource->response);
+    delete resource;
+  }
+
+  return JsValue(
+      GetIsolateProviderPtr(),
+      GetContext(),
+      CHECKED_TO_LOCAL(
+          isolate,
+          v8::String::NewFromUtf8(
+              isolate, response->content(), v8::NewStringType::kNormal, response->size())));
+}
+
 AdblockPlus::JsValue AdblockPlus::JsEngine::NewValue(int64_t val)
 {
   const JsContext context(GetIsolate(), *GetContext());
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <list>
 #include <map>
@@ -33,6 +35,9 @@
 #include <AdblockPlus/IWebRequest.h>
 #include <AdblockPlus/JsValue.h>
 #include <AdblockPlus/LogSystem.h>
+#include <AdblockPlus/StartupTimeline.h>
+
+#include "JsSources.h"
 
 namespace AdblockPlus
 {
@@ -126,11 +131,15 @@ namespace AdblockPlus
      * @param interfaces contains implementation for the interfaces JsEngine uses.
      * @param isolate A provider of v8::Isolate, if the value is nullptr then
      *        a default implementation is used.
+     * @param startupStart Origin of the startup timeline, usually the start
+     *        of `Platform::SetUp()`.
      * @return New `JsEngine` instance.
      */
-    static std::unique_ptr<JsEngine> New(const AppInfo& appInfo,
-                                         const Interfaces& interfaces,
-                                         std::unique_ptr<IV8IsolateProvider> isolate = nullptr);
+    static std::unique_ptr<JsEngine>
+    New(const AppInfo& appInfo,
+        const Interfaces& interfaces,
+        std::unique_ptr<IV8IsolateProvider> isolate = nullptr,
+        std::chrono::steady_clock::time_point startupStart = std::chrono::steady_clock::now());
 
     /**
      * Registers the callback function for an event.
@@ -162,6 +171,14 @@ namespace AdblockPlus
      */
     JsValue Evaluate(const std::string& source, const std::string& filename = "");
 
+    /**
+     * Evaluates a script embedded in the library. V8 refers to its source in
+     * read-only data instead of copying it.
+     * @param jsSource Entry of the `jsSources` table.
+     * @return Result of the evaluated script.
+     */
+    JsValue Evaluate(const JsSource& jsSource);
+
     /**
      * Initiates a garbage collection.
      */
@@ -193,6 +210,15 @@ namespace AdblockPlus
 #endif
     //@}
 
+    /**
+     * Creates a new JavaScript string with the content of a preloaded filter
+     * list. ASCII content is not copied, the string references the buffer of
+     * `response` and keeps it alive. Other content is decoded as UTF-8.
+     * @param response Preloaded filter list, has to exist.
+     * @return New `JsValue` instance.
+     */
+    JsValue NewValue(std::unique_ptr<IPreloadedFilterResponse> response);
+
     /**
      * Creates a new JavaScript object.
      * @return New `JsValue` instance.
@@ -267,6 +293,54 @@ namespace AdblockPlus
      */
     void NotifyLowMemory();
 
+    //@{
+    /**
+     * Marks latency sensitive work, e.g. queued match requests, as pending.
+     * Calls have to be balanced.
+     */
+    void BeginForegroundWork();
+    void EndForegroundWork();
+    //@}
+
+    /**
+     * Runs background work such as timer tasks and web request callbacks,
+     * which enter JS. While foreground work is pending, the task is put back
+     * on the timer queue instead, so it doesn't delay e.g. a queued match
+     * request and the thread delivering it isn't blocked. A task is deferred
+     * for at most 10 ms, so that a steady stream of foreground work doesn't
+     * starve it. A task that is already running is not interrupted.
+     * @param task Task to run.
+     */
+    void RunBackgroundTask(std::function<void()>&& task);
+
+    /**
+     * Adds a phase to the startup timeline, times are relative to the
+     * `startupStart` passed to `New()`. Thread-safe.
+     * @param name Name of the phase.
+     * @param start Time the phase started.
+     * @param end Time the phase ended.
+     */
+    void RecordStartupPhase(
+        const std::string& name,
+        std::chrono::steady_clock::time_point start,
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now());
+
+    /**
+     * Retrieves the phases recorded so far, see `RecordStartupPhase()`.
+     */
+    StartupTimeline GetStartupTimeline() const;
+
+    //@{
+    /**
+     * Keeps files opened by `_fileSystem.openWrite()` or
+     * `_fileSystem.openAppend()` until they are closed.
+     * Only called with the engine locked.
+     */
+    int StoreWriteStream(std::unique_ptr<IFileSystem::WriteStream> stream);
+    IFileSystem::WriteStream* GetWriteStream(int id) const;
+    std::unique_ptr<IFileSystem::WriteStream> TakeWriteStream(int id);
+    //@}
+
     ITimer& GetTimer() const
     {
       return timer;
@@ -294,6 +368,8 @@ namespace AdblockPlus
 
   private:
     void CallTimerTask(const JsWeakValuesID& timerParamsID);
+    void RunOrDeferBackgroundTask(const std::shared_ptr<std::function<void()>>& task,
+                                  std::chrono::steady_clock::time_point deadline);
 
     JsEngine(const Interfaces& interfaces, std::unique_ptr<IV8IsolateProvider> isolate);
 
@@ -341,5 +417,11 @@ namespace AdblockPlus
     JsWeakValuesLists jsWeakValuesLists_;
     std::mutex jsWeakValuesListsMutex_;
     std::vector<ScopedWeakValues::RegisteredWeakValue*> registeredWeakValues_;
+    std::atomic<int> pendingForegroundWork_{0};
+    std::map<int, std::unique_ptr<IFileSystem::WriteStream>> writeStreams_;
+    int lastWriteStreamId_ = 0;
+    std::chrono::steady_clock::time_point startupStart_;
+    StartupTimeline startupTimeline_;
+    mutable std::mutex startupTimelineMutex_;
   };
 }
@@ -0,0 +1,41 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace AdblockPlus
+{
+  /**
+   * Library script embedded by convert_js.py. The source is ASCII and is
+   * stored in read-only data of the binary, so it stays valid as long as the
+   * process runs.
+   */
+  struct JsSource
+  {
+    const char* filename;
+    const char* source;
+    size_t sourceLength;
+  };
+}
+
+/**
+ * Generated table of the library scripts, terminated by an entry with a null
+ * `filename`.
+ */
+extern const AdblockPlus::JsSource jsSources[];
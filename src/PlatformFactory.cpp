@@ -18,6 +18,7 @@
 #include <AdblockPlus/PlatformFactory.h>
 
 #include "AsyncExecutor.h"
+#include "CompressingFileSystem.h"
 #include "DefaultFileSystem.h"
 #include "DefaultLogSystem.h"
 #include "DefaultPlatform.h"
@@ -46,6 +47,8 @@ std::unique_ptr<Platform> PlatformFactory::CreatePlatform(CreationParameters&& p
         *parameters.executor,
         std::unique_ptr<DefaultFileSystemSync>(new DefaultFileSystemSync(parameters.basePath))));
   }
+  if (parameters.compressFilterStorage)
+    parameters.fileSystem.reset(new CompressingFileSystem(std::move(parameters.fileSystem)));
   if (!parameters.resourceReader)
     parameters.resourceReader.reset(new DefaultResourceReader());
 
@@ -0,0 +1,73 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "PrioritizedActiveObject.h"
+
+using namespace AdblockPlus;
+
+PrioritizedActiveObject::PrioritizedActiveObject() : nextSequence(0), shouldThreadStop(false)
+{
+  thread = std::thread([this] {
+    ThreadFunc();
+  });
+}
+
+PrioritizedActiveObject::~PrioritizedActiveObject()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    shouldThreadStop = true;
+  }
+  conditionVariable.notify_one();
+  thread.join();
+}
+
+void PrioritizedActiveObject::Post(Call&& call, int priority)
+{
+  if (!call)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    calls.push({priority, nextSequence++, std::move(call)});
+  }
+  conditionVariable.notify_one();
+}
+
+void PrioritizedActiveObject::ThreadFunc()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    conditionVariable.wait(lock, [this]() -> bool {
+      return shouldThreadStop || !calls.empty();
+    });
+    // already posted calls are finished before the thread stops
+    if (calls.empty())
+      return;
+    Call call = std::move(const_cast<QueuedCall&>(calls.top()).call);
+    calls.pop();
+    lock.unlock();
+    try
+    {
+      call();
+    }
+    catch (...)
+    {
+      // do nothing, but the thread will be alive.
+    }
+    lock.lock();
+  }
+}
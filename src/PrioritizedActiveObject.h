@@ -0,0 +1,79 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace AdblockPlus
+{
+  /**
+   * Like ActiveObject it executes posted callable objects in a single
+   * background thread, but calls with a higher priority are executed first.
+   * Calls of the same priority are executed in the order they were posted.
+   * In the destructor it waits for the finishing of all already posted calls.
+   */
+  class PrioritizedActiveObject
+  {
+  public:
+    typedef std::function<void()> Call;
+
+    PrioritizedActiveObject();
+    ~PrioritizedActiveObject();
+
+    /**
+     * Adds the `call` to be executed in the worker thread.
+     * @param call object.
+     * @param priority Calls with greater values are executed first.
+     */
+    void Post(Call&& call, int priority);
+
+  private:
+    struct QueuedCall
+    {
+      int priority;
+      uint64_t sequence;
+      Call call;
+    };
+    struct QueuedCallComparator
+    {
+      bool operator()(const QueuedCall& c1, const QueuedCall& c2) const
+      {
+        if (c1.priority != c2.priority)
+          return c1.priority < c2.priority;
+        // pay attention 2 < 1 because we need the earliest call at the top.
+        return c2.sequence < c1.sequence;
+      }
+    };
+    typedef std::priority_queue<QueuedCall, std::vector<QueuedCall>, QueuedCallComparator>
+        QueuedCalls;
+
+    void ThreadFunc();
+
+    std::mutex mutex;
+    std::condition_variable conditionVariable;
+    QueuedCalls calls;
+    uint64_t nextSequence;
+    bool shouldThreadStop;
+    std::thread thread;
+  };
+}
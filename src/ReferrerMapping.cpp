@@ -15,42 +15,131 @@
  * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include <AdblockPlus/ReferrerMapping.h>
 
 using namespace AdblockPlus;
 
-ReferrerMapping::ReferrerMapping(const int maxCachedUrls) : maxCachedUrls(maxCachedUrls)
+namespace
+{
+  // We need to limit the chain length to ensure we don't block indefinitely
+  // if there's a referrer loop.
+  const int maxChainLength = 10;
+}
+
+ReferrerMapping::ReferrerMapping(const int maxCachedUrls)
+    : maxCachedUrls(maxCachedUrls), cachedUrlCount(0), newest(nullptr), oldest(nullptr),
+      generation(1)
 {
 }
 
 void ReferrerMapping::Add(const std::string& url, const std::string& referrer)
 {
-  if (mapping.find(url) != mapping.end())
-    cachedUrls.remove(url);
-  cachedUrls.push_back(url);
-  mapping[url] = referrer;
+  Entry& entry = Intern(url);
+  Entry& referrerEntry = Intern(referrer);
 
-  const int urlsToPop = cachedUrls.size() - maxCachedUrls;
-  for (int i = 0; i < urlsToPop; i++)
+  if (entry.referrer)
   {
-    const std::string poppedUrl = cachedUrls.front();
-    cachedUrls.pop_front();
-    mapping.erase(poppedUrl);
+    Unlink(entry);
+    if (entry.referrer != &referrerEntry)
+    {
+      // Chains starting at or passing through the URL are changed.
+      ++generation;
+      --entry.referrer->referencedBy;
+      ReleaseIfUnused(*entry.referrer);
+      entry.referrer = &referrerEntry;
+      ++referrerEntry.referencedBy;
+    }
   }
+  else
+  {
+    // A URL which has not been recorded yet can only be a part of existing
+    // chains if it's somebody's referrer.
+    if (entry.referencedBy > 0)
+      ++generation;
+    entry.referrer = &referrerEntry;
+    ++referrerEntry.referencedBy;
+    ++cachedUrlCount;
+  }
+
+  entry.older = newest;
+  entry.newer = nullptr;
+  if (newest)
+    newest->newer = &entry;
+  newest = &entry;
+  if (!oldest)
+    oldest = &entry;
+
+  while (cachedUrlCount > maxCachedUrls && oldest)
+    Unmap(*oldest);
 }
 
 std::vector<std::string> ReferrerMapping::BuildReferrerChain(const std::string& url) const
 {
-  std::vector<std::string> referrerChain;
-  // We need to limit the chain length to ensure we don't block indefinitely
-  // if there's a referrer loop.
-  const int maxChainLength = 10;
-  std::map<std::string, std::string>::const_iterator currentEntry = mapping.find(url);
-  for (int i = 0; i < maxChainLength && currentEntry != mapping.end(); i++)
+  auto it = entries.find(url);
+  if (it == entries.end() || !it->second.referrer)
+    return std::vector<std::string>();
+  std::lock_guard<std::mutex> lock(chainCacheMutex);
+  return GetChain(*it->second.referrer);
+}
+
+ReferrerMapping::Entry& ReferrerMapping::Intern(const std::string& url)
+{
+  auto inserted = entries.emplace(url, Entry());
+  Entry& entry = inserted.first->second;
+  if (inserted.second)
+    entry.url = &inserted.first->first;
+  return entry;
+}
+
+void ReferrerMapping::ReleaseIfUnused(Entry& entry)
+{
+  if (!entry.referrer && entry.referencedBy == 0)
+    entries.erase(*entry.url);
+}
+
+void ReferrerMapping::Unlink(Entry& entry)
+{
+  if (entry.newer)
+    entry.newer->older = entry.older;
+  else
+    newest = entry.older;
+  if (entry.older)
+    entry.older->newer = entry.newer;
+  else
+    oldest = entry.newer;
+  entry.newer = entry.older = nullptr;
+}
+
+void ReferrerMapping::Unmap(Entry& entry)
+{
+  if (entry.referencedBy > 0)
+    ++generation;
+  Unlink(entry);
+  --cachedUrlCount;
+  Entry* referrer = entry.referrer;
+  entry.referrer = nullptr;
+  --referrer->referencedBy;
+  if (referrer != &entry)
+    ReleaseIfUnused(*referrer);
+  ReleaseIfUnused(entry);
+}
+
+const std::vector<std::string>& ReferrerMapping::GetChain(const Entry& entry) const
+{
+  if (entry.cachedGeneration == generation)
+    return entry.cachedChain;
+
+  std::vector<std::string>& chain = entry.cachedChain;
+  chain.clear();
+  const Entry* current = &entry;
+  for (int i = 0; i < maxChainLength && current; i++)
   {
-    const std::string& currentUrl = currentEntry->second;
-    referrerChain.insert(referrerChain.begin(), currentUrl);
-    currentEntry = mapping.find(currentUrl);
+    chain.push_back(*current->url);
+    current = current->referrer;
   }
-  return referrerChain;
+  std::reverse(chain.begin(), chain.end());
+  entry.cachedGeneration = generation;
+  return chain;
 }
@@ -59,7 +59,7 @@ namespace ReadPreloadedFilterListCallback
               auto result = jsEngine->NewObject();
               result.SetProperty("exists", exists);
               if (exists)
-                result.SetProperty("content", response->content(), response->size());
+                result.SetProperty("content", jsEngine->NewValue(std::move(response)));
               weakCallbackValue.Values()[0].Call(result);
             });
       }
@@ -0,0 +1,477 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "SignatureVerifier.h"
+
+using namespace AdblockPlus;
+
+namespace
+{
+  typedef std::vector<uint8_t> Bytes;
+  // Little-endian 32-bit limbs.
+  typedef std::vector<uint32_t> BigNumber;
+
+  int Base64Value(char c)
+  {
+    if (c >= 'A' && c <= 'Z')
+      return c - 'A';
+    if (c >= 'a' && c <= 'z')
+      return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+      return c - '0' + 52;
+    if (c == '+')
+      return 62;
+    if (c == '/')
+      return 63;
+    return -1;
+  }
+
+  bool Base64Decode(const std::string& str, Bytes* result)
+  {
+    size_t length = str.size();
+    while (length > 0 && str[length - 1] == '=' && str.size() - length < 2)
+      --length;
+    if (length % 4 == 1)
+      return false;
+
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+      int value = Base64Value(str[i]);
+      if (value < 0)
+        return false;
+      buffer = (buffer << 6) | static_cast<uint32_t>(value);
+      bits += 6;
+      if (bits >= 8)
+      {
+        bits -= 8;
+        result->push_back(static_cast<uint8_t>(buffer >> bits));
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Minimal DER reader, only definite lengths up to 4 bytes are supported.
+   */
+  class DerReader
+  {
+  public:
+    DerReader(const uint8_t* begin, const uint8_t* end) : current(begin), end(end)
+    {
+    }
+
+    bool AtEnd() const
+    {
+      return current == end;
+    }
+
+    bool PeekTag(uint8_t tag) const
+    {
+      return current != end && *current == tag;
+    }
+
+    bool Read(uint8_t tag, DerReader* content)
+    {
+      if (end - current < 2 || *current != tag)
+        return false;
+      const uint8_t* position = current + 1;
+      size_t length = *position++;
+      if (length & 0x80)
+      {
+        size_t lengthBytes = length & 0x7F;
+        if (lengthBytes == 0 || lengthBytes > 4 ||
+            static_cast<size_t>(end - position) < lengthBytes)
+          return false;
+        length = 0;
+        for (size_t i = 0; i < lengthBytes; ++i)
+          length = (length << 8) | *position++;
+      }
+      if (static_cast<size_t>(end - position) < length)
+        return false;
+      *content = DerReader(position, position + length);
+      current = position + length;
+      return true;
+    }
+
+    bool Equals(const uint8_t* data, size_t size) const
+    {
+      return static_cast<size_t>(end - current) == size &&
+             std::equal(current, end, data);
+    }
+
+    const uint8_t* current;
+    const uint8_t* end;
+  };
+
+  const uint8_t kTagInteger = 0x02;
+  const uint8_t kTagBitString = 0x03;
+  const uint8_t kTagOctetString = 0x04;
+  const uint8_t kTagNull = 0x05;
+  const uint8_t kTagObjectId = 0x06;
+  const uint8_t kTagSequence = 0x30;
+
+  // 1.2.840.113549.1.1.1
+  const uint8_t kRsaEncryptionId[] = {0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01};
+  // 1.3.14.3.2.26
+  const uint8_t kSha1Id[] = {0x2B, 0x0E, 0x03, 0x02, 0x1A};
+
+  const size_t kSha1Length = 20;
+
+  // Reads an algorithm identifier with optional NULL parameters.
+  bool ReadAlgorithm(DerReader& reader, const uint8_t* id, size_t idSize)
+  {
+    DerReader algorithm(nullptr, nullptr);
+    DerReader oid(nullptr, nullptr);
+    DerReader parameters(nullptr, nullptr);
+    if (!reader.Read(kTagSequence, &algorithm) || !algorithm.Read(kTagObjectId, &oid) ||
+        !oid.Equals(id, idSize))
+      return false;
+    if (algorithm.PeekTag(kTagNull) &&
+        (!algorithm.Read(kTagNull, &parameters) || !parameters.AtEnd()))
+      return false;
+    return algorithm.AtEnd();
+  }
+
+  BigNumber FromBytes(const uint8_t* begin, const uint8_t* end)
+  {
+    while (begin != end && *begin == 0)
+      ++begin;
+    BigNumber result((end - begin + 3) / 4, 0);
+    size_t shift = 0;
+    for (const uint8_t* it = end; it != begin; ++shift)
+    {
+      --it;
+      result[shift / 4] |= static_cast<uint32_t>(*it) << (8 * (shift % 4));
+    }
+    return result;
+  }
+
+  bool ReadPublicKey(const Bytes& key, BigNumber* modulus, BigNumber* exponent)
+  {
+    DerReader reader(key.data(), key.data() + key.size());
+    DerReader keyInfo(nullptr, nullptr);
+    DerReader bitString(nullptr, nullptr);
+    if (!reader.Read(kTagSequence, &keyInfo) || !reader.AtEnd() ||
+        !ReadAlgorithm(keyInfo, kRsaEncryptionId, sizeof(kRsaEncryptionId)) ||
+        !keyInfo.Read(kTagBitString, &bitString) || !keyInfo.AtEnd())
+      return false;
+
+    // The first byte of the bit string is the number of unused bits.
+    if (bitString.AtEnd() || *bitString.current != 0)
+      return false;
+    ++bitString.current;
+
+    DerReader rsaKey(nullptr, nullptr);
+    DerReader n(nullptr, nullptr);
+    DerReader e(nullptr, nullptr);
+    if (!bitString.Read(kTagSequence, &rsaKey) || !bitString.AtEnd() ||
+        !rsaKey.Read(kTagInteger, &n) || !rsaKey.Read(kTagInteger, &e) || !rsaKey.AtEnd())
+      return false;
+
+    *modulus = FromBytes(n.current, n.end);
+    *exponent = FromBytes(e.current, e.end);
+    // Montgomery multiplication below requires an odd modulus.
+    return !modulus->empty() && !exponent->empty() && ((*modulus)[0] & 1);
+  }
+
+  // Compares a + carry * 2^(32*k) to b, both having k limbs.
+  bool IsGreaterOrEqual(const BigNumber& a, uint32_t carry, const BigNumber& b)
+  {
+    if (carry)
+      return true;
+    for (size_t i = a.size(); i-- > 0;)
+    {
+      if (a[i] != b[i])
+        return a[i] > b[i];
+    }
+    return true;
+  }
+
+  void Subtract(BigNumber& a, const BigNumber& b)
+  {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+      uint64_t difference = static_cast<uint64_t>(a[i]) - b[i] - borrow;
+      a[i] = static_cast<uint32_t>(difference);
+      borrow = (difference >> 32) & 1;
+    }
+  }
+
+  /**
+   * Modular exponentiation using Montgomery multiplication.
+   */
+  class Montgomery
+  {
+  public:
+    explicit Montgomery(const BigNumber& modulus) : n(modulus), k(modulus.size())
+    {
+      // Newton's iteration for n[0]^-1 mod 2^32, each step doubles the
+      // number of correct bits.
+      uint32_t inverse = n[0];
+      for (int i = 0; i < 5; ++i)
+        inverse *= 2 - n[0] * inverse;
+      n0Inverse = 0 - inverse;
+
+      // R^2 mod n where R = 2^(32*k).
+      r2.assign(k, 0);
+      r2[0] = 1;
+      for (size_t i = 0; i < 64 * k; ++i)
+      {
+        uint32_t carry = r2[k - 1] >> 31;
+        for (size_t j = k - 1; j > 0; --j)
+          r2[j] = (r2[j] << 1) | (r2[j - 1] >> 31);
+        r2[0] <<= 1;
+        if (IsGreaterOrEqual(r2, carry, n))
+          Subtract(r2, n);
+      }
+    }
+
+    // Returns base^exponent mod n, base has to be less than n.
+    BigNumber Power(BigNumber base, const BigNumber& exponent) const
+    {
+      base.resize(k, 0);
+      BigNumber one(k, 0);
+      one[0] = 1;
+      BigNumber x = Multiply(base, r2);
+      BigNumber result = Multiply(one, r2);
+      for (size_t i = exponent.size(); i-- > 0;)
+      {
+        for (int bit = 31; bit >= 0; --bit)
+        {
+          result = Multiply(result, result);
+          if ((exponent[i] >> bit) & 1)
+            result = Multiply(result, x);
+        }
+      }
+      return Multiply(result, one);
+    }
+
+  private:
+    // Returns a * b / R mod n.
+    BigNumber Multiply(const BigNumber& a, const BigNumber& b) const
+    {
+      std::vector<uint32_t> t(k + 2, 0);
+      for (size_t i = 0; i < k; ++i)
+      {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < k; ++j)
+        {
+          uint64_t sum = t[j] + static_cast<uint64_t>(a[j]) * b[i] + carry;
+          t[j] = static_cast<uint32_t>(sum);
+          carry = sum >> 32;
+        }
+        uint64_t sum = t[k] + carry;
+        t[k] = static_cast<uint32_t>(sum);
+        t[k + 1] = static_cast<uint32_t>(sum >> 32);
+
+        uint32_t m = t[0] * n0Inverse;
+        carry = (t[0] + static_cast<uint64_t>(m) * n[0]) >> 32;
+        for (size_t j = 1; j < k; ++j)
+        {
+          sum = t[j] + static_cast<uint64_t>(m) * n[j] + carry;
+          t[j - 1] = static_cast<uint32_t>(sum);
+          carry = sum >> 32;
+        }
+        sum = t[k] + carry;
+        t[k - 1] = static_cast<uint32_t>(sum);
+        t[k] = t[k + 1] + static_cast<uint32_t>(sum >> 32);
+      }
+      BigNumber result(t.begin(), t.begin() + k);
+      if (IsGreaterOrEqual(result, t[k], n))
+        Subtract(result, n);
+      return result;
+    }
+
+    const BigNumber& n;
+    const size_t k;
+    uint32_t n0Inverse;
+    BigNumber r2;
+  };
+
+  uint32_t RotateLeft(uint32_t value, int bits)
+  {
+    return (value << bits) | (value >> (32 - bits));
+  }
+
+  Bytes Sha1(const std::string& data)
+  {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    std::string message = data;
+    uint64_t bitLength = static_cast<uint64_t>(data.size()) * 8;
+    message.push_back(static_cast<char>(0x80));
+    while (message.size() % 64 != 56)
+      message.push_back(0);
+    for (int i = 7; i >= 0; --i)
+      message.push_back(static_cast<char>(bitLength >> (8 * i)));
+
+    uint32_t w[80];
+    for (size_t offset = 0; offset < message.size(); offset += 64)
+    {
+      for (int i = 0; i < 16; ++i)
+      {
+        const uint8_t* word = reinterpret_cast<const uint8_t*>(message.data() + offset + 4 * i);
+        w[i] = (static_cast<uint32_t>(word[0]) << 24) | (static_cast<uint32_t>(word[1]) << 16) |
+               (static_cast<uint32_t>(word[2]) << 8) | word[3];
+      }
+      for (int i = 16; i < 80; ++i)
+        w[i] = RotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+      uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+      for (int i = 0; i < 80; ++i)
+      {
+        uint32_t f, constant;
+        if (i < 20)
+        {
+          f = (b & c) | (~b & d);
+          constant = 0x5A827999;
+        }
+        else if (i < 40)
+        {
+          f = b ^ c ^ d;
+          constant = 0x6ED9EBA1;
+        }
+        else if (i < 60)
+        {
+          f = (b & c) | (b & d) | (c & d);
+          constant = 0x8F1BBCDC;
+        }
+        else
+        {
+          f = b ^ c ^ d;
+          constant = 0xCA62C1D6;
+        }
+        uint32_t temp = RotateLeft(a, 5) + f + e + constant + w[i];
+        e = d;
+        d = c;
+        c = RotateLeft(b, 30);
+        b = a;
+        a = temp;
+      }
+      h[0] += a;
+      h[1] += b;
+      h[2] += c;
+      h[3] += d;
+      h[4] += e;
+    }
+
+    Bytes digest;
+    for (uint32_t value : h)
+    {
+      for (int i = 3; i >= 0; --i)
+        digest.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+    return digest;
+  }
+
+  // Checks the PKCS#1 v1.5 encoding EM = 00 01 FF..FF 00 DigestInfo.
+  bool CheckEncodedDigest(const Bytes& encoded, const Bytes& digest)
+  {
+    auto it = encoded.begin();
+    if (encoded.size() < 11 || *it++ != 0 || *it++ != 1)
+      return false;
+    size_t paddingLength = 0;
+    for (; it != encoded.end() && *it == 0xFF; ++it)
+      ++paddingLength;
+    if (paddingLength < 8 || it == encoded.end() || *it++ != 0)
+      return false;
+
+    DerReader reader(&*it, encoded.data() + encoded.size());
+    DerReader digestInfo(nullptr, nullptr);
+    DerReader hash(nullptr, nullptr);
+    return reader.Read(kTagSequence, &digestInfo) && reader.AtEnd() &&
+           ReadAlgorithm(digestInfo, kSha1Id, sizeof(kSha1Id)) &&
+           digestInfo.Read(kTagOctetString, &hash) && digestInfo.AtEnd() &&
+           hash.Equals(digest.data(), digest.size());
+  }
+}
+
+SignatureVerifier::SignatureVerifier(size_t maxCachedResults) : maxCachedResults(maxCachedResults)
+{
+}
+
+bool SignatureVerifier::Verify(const std::string& key,
+                               const std::string& signature,
+                               const std::string& uri,
+                               const std::string& host,
+                               const std::string& userAgent)
+{
+  std::string data = uri + '\0' + host + '\0' + userAgent;
+  // Base64 strings can't contain '\0', so the cache key is unambiguous.
+  std::string cacheKey = key + '\0' + signature + '\0' + data;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = resultsIndex.find(cacheKey);
+    if (it != resultsIndex.end())
+    {
+      results.splice(results.begin(), results, it->second);
+      return it->second->second;
+    }
+  }
+
+  bool result = VerifyRsaSha1(key, signature, data);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (maxCachedResults == 0 || resultsIndex.count(cacheKey))
+    return result;
+  if (results.size() >= maxCachedResults)
+  {
+    resultsIndex.erase(results.back().first);
+    results.pop_back();
+  }
+  results.emplace_front(cacheKey, result);
+  resultsIndex.emplace(std::move(cacheKey), results.begin());
+  return result;
+}
+
+// static
+bool SignatureVerifier::VerifyRsaSha1(const std::string& key,
+                                      const std::string& signature,
+                                      const std::string& data)
+{
+  Bytes keyBytes;
+  Bytes signatureBytes;
+  BigNumber modulus;
+  BigNumber exponent;
+  if (!Base64Decode(key, &keyBytes) || !Base64Decode(signature, &signatureBytes) ||
+      !ReadPublicKey(keyBytes, &modulus, &exponent))
+    return false;
+
+  BigNumber signatureValue =
+      FromBytes(signatureBytes.data(), signatureBytes.data() + signatureBytes.size());
+  if (signatureValue.size() > modulus.size() ||
+      (signatureValue.size() == modulus.size() && IsGreaterOrEqual(signatureValue, 0, modulus)))
+    return false;
+
+  BigNumber message = Montgomery(modulus).Power(signatureValue, exponent);
+
+  // Convert the result to the big-endian encoded message of the modulus length.
+  size_t modulusLength = modulus.size() * 4;
+  for (uint32_t top = modulus.back(); !(top & 0xFF000000); top <<= 8)
+    --modulusLength;
+  Bytes encoded(modulusLength, 0);
+  for (size_t i = 0; i < modulusLength; ++i)
+    encoded[modulusLength - 1 - i] = static_cast<uint8_t>(message[i / 4] >> (8 * (i % 4)));
+
+  return CheckEncodedDigest(encoded, Sha1(data));
+}
@@ -0,0 +1,74 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace AdblockPlus
+{
+  /**
+   * Native implementation of the sitekey signature check, see
+   * IFilterEngine::VerifySignature(). Verifies RSA PKCS#1 v1.5 signatures
+   * with SHA-1 digests and remembers results of recent checks.
+   * It's safe to call `Verify()` from several threads.
+   */
+  class SignatureVerifier
+  {
+  public:
+    /**
+     * Constructor.
+     * @param maxCachedResults Number of verification results to remember.
+     */
+    explicit SignatureVerifier(size_t maxCachedResults = 100);
+
+    /**
+     * Checks that `signature` is a signature of the request made by `key`,
+     * results are cached.
+     * @return `true` if the signature is valid, `false` otherwise including
+     *         malformed arguments.
+     */
+    bool Verify(const std::string& key,
+                const std::string& signature,
+                const std::string& uri,
+                const std::string& host,
+                const std::string& userAgent);
+
+    /**
+     * Verifies a signature without using the cache.
+     * @param key Base64 encoded DER `SubjectPublicKeyInfo` of an RSA key.
+     * @param signature Base64 encoded signature.
+     * @param data Signed data.
+     */
+    static bool VerifyRsaSha1(const std::string& key,
+                              const std::string& signature,
+                              const std::string& data);
+
+  private:
+    typedef std::list<std::pair<std::string, bool>> Results;
+
+    const size_t maxCachedResults;
+    std::mutex mutex;
+    // Most recently used results come first.
+    Results results;
+    std::unordered_map<std::string, Results::iterator> resultsIndex;
+  };
+}
@@ -104,6 +104,16 @@ int Subscription::GetVersion() const
   return implementation->GetVersion();
 }
 
+int Subscription::GetLastUpdateAddedCount() const
+{
+  return implementation->GetLastUpdateAddedCount();
+}
+
+int Subscription::GetLastUpdateRemovedCount() const
+{
+  return implementation->GetLastUpdateRemovedCount();
+}
+
 bool Subscription::operator==(const Subscription& other) const
 {
   return *implementation == *(other.implementation);
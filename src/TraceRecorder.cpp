@@ -0,0 +1,147 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TraceRecorder.h"
+
+#include <cstdio>
+
+using namespace AdblockPlus;
+
+TraceRecorder::Line::Line(const std::string& function)
+{
+  text = "{\"_fn\":";
+  AppendQuoted(function);
+}
+
+TraceRecorder::Line& TraceRecorder::Line::AddString(const std::string& name,
+                                                    const std::string& value)
+{
+  AddName(name);
+  AppendQuoted(value);
+  return *this;
+}
+
+TraceRecorder::Line& TraceRecorder::Line::AddList(const std::string& name,
+                                                  const std::vector<std::string>& values)
+{
+  AddName(name);
+  text += '[';
+  for (size_t i = 0; i < values.size(); ++i)
+  {
+    if (i > 0)
+      text += ',';
+    AppendQuoted(values[i]);
+  }
+  text += ']';
+  return *this;
+}
+
+TraceRecorder::Line& TraceRecorder::Line::AddInt(const std::string& name, int64_t value)
+{
+  AddName(name);
+  text += std::to_string(value);
+  return *this;
+}
+
+TraceRecorder::Line& TraceRecorder::Line::AddBool(const std::string& name, bool value)
+{
+  AddName(name);
+  text += value ? "true" : "false";
+  return *this;
+}
+
+std::string TraceRecorder::Line::Finish(std::chrono::steady_clock::time_point started)
+{
+  AddInt("_us",
+         std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - started)
+             .count());
+  text += '}';
+  return std::move(text);
+}
+
+void TraceRecorder::Line::AddName(const std::string& name)
+{
+  text += ',';
+  AppendQuoted(name);
+  text += ':';
+}
+
+void TraceRecorder::Line::AppendQuoted(const std::string& value)
+{
+  text += '"';
+  for (char c : value)
+  {
+    if (c == '"' || c == '\\')
+    {
+      text += '\\';
+      text += c;
+    }
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      char escaped[7];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      text += escaped;
+    }
+    else
+      text += c;
+  }
+  text += '"';
+}
+
+void TraceRecorder::Start(size_t maxCalls)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  this->maxCalls = maxCalls;
+  lines.clear();
+  lines.reserve(maxCalls);
+  next = 0;
+  isRecording = maxCalls > 0;
+}
+
+void TraceRecorder::Stop()
+{
+  isRecording = false;
+}
+
+void TraceRecorder::Record(std::string&& line)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!isRecording)
+    return;
+  if (lines.size() < maxCalls)
+  {
+    lines.push_back(std::move(line));
+    return;
+  }
+  lines[next] = std::move(line);
+  next = (next + 1) % maxCalls;
+}
+
+std::string TraceRecorder::Take()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::string result;
+  for (size_t i = 0; i < lines.size(); ++i)
+  {
+    result += lines[(next + i) % lines.size()];
+    result += '\n';
+  }
+  lines.clear();
+  next = 0;
+  return result;
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace AdblockPlus
+{
+  /**
+   * Keeps the most recent calls of the filter engine as JSON lines in the
+   * format of data/rec_*.log, see IFilterEngine::StartTraceRecording().
+   * It's safe to use from several threads.
+   */
+  class TraceRecorder
+  {
+  public:
+    /**
+     * Builds the JSON object of one call.
+     */
+    class Line
+    {
+    public:
+      /**
+       * Constructor.
+       * @param function Name of the call, stored as "_fn".
+       */
+      explicit Line(const std::string& function);
+
+      Line& AddString(const std::string& name, const std::string& value);
+      Line& AddList(const std::string& name, const std::vector<std::string>& values);
+      Line& AddInt(const std::string& name, int64_t value);
+      Line& AddBool(const std::string& name, bool value);
+
+      /**
+       * Adds the latency of the call as "_us" and closes the object.
+       * @param started Time the call started.
+       * @return The complete line without a line break.
+       */
+      std::string Finish(std::chrono::steady_clock::time_point started);
+
+    private:
+      std::string text;
+
+      void AddName(const std::string& name);
+      void AppendQuoted(const std::string& value);
+    };
+
+    /**
+     * Starts recording, previously recorded calls are dropped.
+     * @param maxCalls Number of calls to keep, older calls are overwritten.
+     */
+    void Start(size_t maxCalls);
+
+    /**
+     * Stops recording, recorded calls are kept until `Take()`.
+     */
+    void Stop();
+
+    bool IsRecording() const
+    {
+      return isRecording.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Stores a line built by `Line`, ignored unless recording.
+     */
+    void Record(std::string&& line);
+
+    /**
+     * Removes the recorded calls.
+     * @return The calls, oldest first, each followed by a line break.
+     */
+    std::string Take();
+
+  private:
+    std::atomic<bool> isRecording{false};
+    std::mutex mutex;
+    size_t maxCalls = 0;
+    // Ring buffer, once it's full `next` is the oldest line.
+    std::vector<std::string> lines;
+    size_t next = 0;
+  };
+}
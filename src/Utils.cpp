@@ -15,13 +15,31 @@
  * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #ifdef _WIN32
 #include <Shlwapi.h>
 #include <Windows.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ABP_ASCII_SCAN_SSE2
+#include <emmintrin.h>
+#ifdef __AVX2__
+#define ABP_ASCII_SCAN_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ABP_ASCII_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
 #include "Utils.h"
 
 using namespace AdblockPlus;
@@ -63,6 +81,15 @@ v8::MaybeLocal<v8::String> Utils::StringBufferToV8String(v8::Isolate* isolate,
       isolate, reinterpret_cast<const char*>(str.data()), v8::NewStringType::kNormal, str.size());
 }
 
+v8::MaybeLocal<v8::String>
+Utils::ToV8String(v8::Isolate* isolate, const char* data, size_t size, bool isAscii)
+{
+  if (isAscii)
+    return v8::String::NewFromOneByte(
+        isolate, reinterpret_cast<const uint8_t*>(data), v8::NewStringType::kNormal, size);
+  return v8::String::NewFromUtf8(isolate, data, v8::NewStringType::kNormal, size);
+}
+
 void Utils::ThrowExceptionInJS(v8::Isolate* isolate, const std::string& str)
 {
   auto maybe = Utils::ToV8String(isolate, str);
@@ -74,6 +101,139 @@ void Utils::ThrowExceptionInJS(v8::Isolate* isolate, const std::string& str)
     isolate->ThrowException(maybe.ToLocalChecked());
 }
 
+namespace
+{
+  inline unsigned CountTrailingZeros(uint32_t mask)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+  }
+
+  // Returns the first byte equal to `first` or `second`, clears `isAscii`
+  // if there are non-ASCII bytes before it.
+  const char* FindEitherOf(
+      const char* begin, const char* end, char first, char second, bool* isAscii)
+  {
+    bool ascii = true;
+    const char* position = begin;
+    const char* found = nullptr;
+#if defined(ABP_ASCII_SCAN_AVX2)
+    const __m256i first32 = _mm256_set1_epi8(first);
+    const __m256i second32 = _mm256_set1_epi8(second);
+    for (; !found && end - position >= 32; position += 32)
+    {
+      __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position));
+      uint32_t matches = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(
+          _mm256_cmpeq_epi8(chunk, first32), _mm256_cmpeq_epi8(chunk, second32))));
+      uint32_t nonAscii = static_cast<uint32_t>(_mm256_movemask_epi8(chunk));
+      if (matches)
+      {
+        unsigned index = CountTrailingZeros(matches);
+        nonAscii &= (1u << index) - 1;
+        found = position + index;
+      }
+      ascii = ascii && !nonAscii;
+    }
+#endif
+#if defined(ABP_ASCII_SCAN_SSE2)
+    const __m128i first16 = _mm_set1_epi8(first);
+    const __m128i second16 = _mm_set1_epi8(second);
+    for (; !found && end - position >= 16; position += 16)
+    {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+      uint32_t matches = static_cast<uint32_t>(_mm_movemask_epi8(
+          _mm_or_si128(_mm_cmpeq_epi8(chunk, first16), _mm_cmpeq_epi8(chunk, second16))));
+      uint32_t nonAscii = static_cast<uint32_t>(_mm_movemask_epi8(chunk));
+      if (matches)
+      {
+        unsigned index = CountTrailingZeros(matches);
+        nonAscii &= (1u << index) - 1;
+        found = position + index;
+      }
+      ascii = ascii && !nonAscii;
+    }
+#elif defined(ABP_ASCII_SCAN_NEON)
+    const uint8x16_t first16 = vdupq_n_u8(static_cast<uint8_t>(first));
+    const uint8x16_t second16 = vdupq_n_u8(static_cast<uint8_t>(second));
+    for (; end - position >= 16; position += 16)
+    {
+      uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(position));
+      uint64x2_t matches =
+          vreinterpretq_u64_u8(vorrq_u8(vceqq_u8(chunk, first16), vceqq_u8(chunk, second16)));
+      // The exact position is left to the byte loop below.
+      if (vgetq_lane_u64(matches, 0) | vgetq_lane_u64(matches, 1))
+        break;
+      uint64x2_t highBits = vreinterpretq_u64_u8(vandq_u8(chunk, vdupq_n_u8(0x80)));
+      ascii = ascii && !(vgetq_lane_u64(highBits, 0) | vgetq_lane_u64(highBits, 1));
+    }
+#endif
+    if (!found)
+    {
+      for (; position != end && *position != first && *position != second; ++position)
+        ascii = ascii && !(static_cast<unsigned char>(*position) & 0x80);
+      found = position;
+    }
+    if (isAscii)
+      *isAscii = *isAscii && ascii;
+    return found;
+  }
+}
+
+const char* Utils::FindLineBreak(const char* begin, const char* end, bool* isAscii)
+{
+  return FindEitherOf(begin, end, '\n', '\r', isAscii);
+}
+
+const char* Utils::FindDelimiter(const char* begin, const char* end, char delim, bool* isAscii)
+{
+  return FindEitherOf(begin, end, delim, delim, isAscii);
+}
+
+bool Utils::IsAscii(const char* data, size_t size)
+{
+  size_t i = 0;
+  // Bytes are combined over 64 byte blocks to keep the loop free of
+  // unpredictable branches, non-ASCII content is rare.
+#if defined(ABP_ASCII_SCAN_SSE2)
+  for (; i + 64 <= size; i += 64)
+  {
+    const __m128i* block = reinterpret_cast<const __m128i*>(data + i);
+    __m128i low = _mm_or_si128(_mm_loadu_si128(block), _mm_loadu_si128(block + 1));
+    __m128i high = _mm_or_si128(_mm_loadu_si128(block + 2), _mm_loadu_si128(block + 3));
+    if (_mm_movemask_epi8(_mm_or_si128(low, high)))
+      return false;
+  }
+#elif defined(ABP_ASCII_SCAN_NEON)
+  for (; i + 64 <= size; i += 64)
+  {
+    const uint8_t* block = reinterpret_cast<const uint8_t*>(data + i);
+    uint8x16_t combined = vorrq_u8(vorrq_u8(vld1q_u8(block), vld1q_u8(block + 16)),
+                                   vorrq_u8(vld1q_u8(block + 32), vld1q_u8(block + 48)));
+    uint64x2_t highBits = vreinterpretq_u64_u8(vandq_u8(combined, vdupq_n_u8(0x80)));
+    if (vgetq_lane_u64(highBits, 0) | vgetq_lane_u64(highBits, 1))
+      return false;
+  }
+#endif
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+  {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    if (word & 0x8080808080808080ull)
+      return false;
+  }
+  for (; i < size; ++i)
+  {
+    if (static_cast<unsigned char>(data[i]) & 0x80)
+      return false;
+  }
+  return true;
+}
+
 #ifdef _WIN32
 std::wstring Utils::ToUtf16String(const std::string& str)
 {
@@ -131,19 +291,18 @@ std::wstring Utils::CanonizeUrl(const std::wstring& url)
 
 std::vector<std::string> Utils::SplitString(const std::string& value, const char delim)
 {
-  std::stringstream ss(value);
-  std::string item;
   std::vector<std::string> elems;
+  if (value.empty())
+    return elems;
 
-  while (std::getline(ss, item, delim))
-  {
-    elems.push_back(item);
-  }
-
-  if (!value.empty() && value.back() == delim)
+  const char* end = value.data() + value.size();
+  for (const char* begin = value.data();; ++begin)
   {
-    elems.push_back("");
+    const char* found = Utils::FindDelimiter(begin, end, delim);
+    elems.emplace_back(begin, found);
+    if (found == end)
+      break;
+    begin = found;
   }
-
   return elems;
 }
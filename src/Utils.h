@@ -77,6 +77,12 @@ namespace AdblockPlus
     v8::MaybeLocal<v8::String> ToV8String(v8::Isolate* isolate, const std::string& str);
     v8::MaybeLocal<v8::String> StringBufferToV8String(v8::Isolate* isolate,
                                                       const StringBuffer& bytes);
+    /*
+     * Creates a V8 string from UTF-8 data, skips decoding if the caller
+     * already knows that the data is pure ASCII.
+     */
+    v8::MaybeLocal<v8::String>
+    ToV8String(v8::Isolate* isolate, const char* data, size_t size, bool isAscii);
     void ThrowExceptionInJS(v8::Isolate* isolate, const std::string& str);
 
     // Code for templated function has to be in a header file, can't be in .cpp
@@ -97,6 +103,25 @@ namespace AdblockPlus
       return trimmed;
     }
     std::vector<std::string> SplitString(const std::string& value, const char delim);
+
+    /*
+     * Checks whether all bytes of the buffer are 7-bit ASCII,
+     * uses SSE2 or NEON where available.
+     */
+    bool IsAscii(const char* data, size_t size);
+
+    /*
+     * Returns the first line break ('\n' or '\r') in [begin, end) or `end`.
+     * `isAscii`, if given, is set to false when non-ASCII bytes precede it and
+     * is left untouched otherwise. Uses AVX2, SSE2 or NEON where available.
+     */
+    const char* FindLineBreak(const char* begin, const char* end, bool* isAscii = nullptr);
+
+    /*
+     * Same as FindLineBreak() for an arbitrary delimiter.
+     */
+    const char*
+    FindDelimiter(const char* begin, const char* end, char delim, bool* isAscii = nullptr);
 #ifdef _WIN32
     std::wstring ToUtf16String(const std::string& str);
     std::string ToUtf8String(const std::wstring& str);
@@ -22,6 +22,7 @@
 #include <AdblockPlus/IWebRequest.h>
 #include <AdblockPlus/Platform.h>
 
+#include "FilterListPreparser.h"
 #include "JsContext.h"
 #include "Utils.h"
 
@@ -58,20 +59,34 @@ void JsEngine::ScheduleWebRequest(WebRequestMethod method, const v8::FunctionCal
 
   JsEngine::ScopedWeakValues weakCallbackValue(jsEngine, {converted[2]});
   auto reuqestCallback = [jsEngine, weakCallbackValue](const ServerResponse& response) {
-    AdblockPlus::JsContext context(jsEngine->GetIsolate(), *jsEngine->GetContext());
-    auto resultObject = jsEngine->NewObject();
-    resultObject.SetProperty("status", response.status);
-    resultObject.SetProperty("responseStatus", response.responseStatus);
-    resultObject.SetProperty("responseText", response.responseText);
-
-    auto headersObject = jsEngine->NewObject();
-    for (const auto& header : response.responseHeaders)
-    {
-      headersObject.SetProperty(header.first, header.second);
-    }
-    resultObject.SetProperty("responseHeaders", headersObject);
-
-    weakCallbackValue.Values()[0].Call(resultObject);
+    // The checksum of downloaded filter lists is verified before entering
+    // the engine, usually on the thread of the web request.
+    const bool checksumMismatch = FilterListPreparser::VerifyChecksum(response.responseText) ==
+                                  FilterListPreparser::Checksum::MISMATCH;
+    jsEngine->RunBackgroundTask([jsEngine,
+                                 weakCallbackValue,
+                                 status = response.status,
+                                 responseStatus = response.responseStatus,
+                                 responseHeaders = response.responseHeaders,
+                                 responseText = response.responseText,
+                                 checksumMismatch] {
+      AdblockPlus::JsContext context(jsEngine->GetIsolate(), *jsEngine->GetContext());
+      auto resultObject = jsEngine->NewObject();
+      resultObject.SetProperty("status", status);
+      resultObject.SetProperty("responseStatus", responseStatus);
+      resultObject.SetProperty("responseText", responseText);
+      if (checksumMismatch)
+        resultObject.SetProperty("checksumMismatch", true);
+
+      auto headersObject = jsEngine->NewObject();
+      for (const auto& header : responseHeaders)
+      {
+        headersObject.SetProperty(header.first, header.second);
+      }
+      resultObject.SetProperty("responseHeaders", headersObject);
+
+      weakCallbackValue.Values()[0].Call(resultObject);
+    });
   };
 
   if (method == WebRequestMethod::kGet)
@@ -17,10 +17,43 @@
 
 #include "BaseJsTest.h"
 
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
 #include <AdblockPlus/IFilterEngine.h>
 
 using namespace AdblockPlus;
 
+namespace
+{
+  VirtualClock* dateNowClock = nullptr;
+
+  void VirtualDateNowCallback(const v8::FunctionCallbackInfo<v8::Value>& arguments)
+  {
+    auto now = dateNowClock ? dateNowClock->Now()
+                            : std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch());
+    arguments.GetReturnValue().Set(static_cast<double>(now.count()));
+  }
+
+  ServerResponse FixtureResponse(const FixtureWebRequest::Fixtures& fixtures,
+                                 const std::string& url)
+  {
+    ServerResponse response;
+    response.status = IWebRequest::NS_OK;
+    auto ii = fixtures.find(url.substr(0, url.find('?')));
+    if (ii == fixtures.end())
+    {
+      response.responseStatus = 404;
+      return response;
+    }
+    response.responseStatus = 200;
+    response.responseText = ii->second;
+    return response;
+  }
+}
+
 void DelayedTimer::ProcessImmediateTimers(DelayedTimer::SharedTasks& timerTasks)
 {
   auto ii = timerTasks->begin();
@@ -36,6 +69,95 @@ void DelayedTimer::ProcessImmediateTimers(DelayedTimer::SharedTasks& timerTasks)
   }
 }
 
+VirtualClock::VirtualClock()
+    : now(std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch()))
+{
+}
+
+VirtualClock::~VirtualClock()
+{
+  if (dateNowClock == this)
+    dateNowClock = nullptr;
+}
+
+std::chrono::milliseconds VirtualClock::Now() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return now;
+}
+
+void VirtualClock::Schedule(const std::chrono::milliseconds& timeout, const Callback& callback)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  // Callbacks with the same due time keep the order in which they are added.
+  tasks.emplace(now + std::max(timeout, std::chrono::milliseconds::zero()), callback);
+}
+
+size_t VirtualClock::PendingCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return tasks.size();
+}
+
+size_t VirtualClock::RunPending()
+{
+  return Advance(std::chrono::milliseconds::zero());
+}
+
+size_t VirtualClock::Advance(const std::chrono::milliseconds& duration)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  const auto target = now + duration;
+  size_t count = 0;
+  while (!tasks.empty() && tasks.begin()->first <= target)
+  {
+    auto ii = tasks.begin();
+    now = ii->first;
+    auto callback = std::move(ii->second);
+    tasks.erase(ii);
+    // The callback may schedule further tasks.
+    lock.unlock();
+    callback();
+    ++count;
+    lock.lock();
+  }
+  now = target;
+  return count;
+}
+
+void VirtualClock::InstallInJsEngine(JsEngine& jsEngine)
+{
+  dateNowClock = this;
+  jsEngine.SetGlobalProperty("_virtualDateNow", jsEngine.NewCallback(::VirtualDateNowCallback));
+  jsEngine.Evaluate("Date.now = _virtualDateNow;"
+                    "Math.random = (function()"
+                    "{"
+                    "  let seed = 1;"
+                    "  return () => (seed = seed * 16807 % 2147483647) / 2147483647;"
+                    "})();");
+}
+
+void FixtureWebRequest::GET(const std::string& url,
+                            const HeaderList& requestHeaders,
+                            const RequestCallback& callback)
+{
+  auto response = ::FixtureResponse(fixtures, url);
+  ++requestCount;
+  responseBytes += response.responseText.size();
+  scheduler([response, callback] { callback(response); });
+}
+
+void FixtureWebRequest::HEAD(const std::string& url,
+                             const HeaderList& requestHeaders,
+                             const RequestCallback& callback)
+{
+  auto response = ::FixtureResponse(fixtures, url);
+  response.responseText.clear();
+  ++requestCount;
+  scheduler([response, callback] { callback(response); });
+}
+
 IFilterEngine& CreateFilterEngine(Platform& platform,
                                   const FilterEngineFactory::CreationParameters& creationParams)
 {
@@ -50,6 +172,57 @@ IFilterEngine& CreateFilterEngine(Platform& platform,
   return platform.GetFilterEngine();
 }
 
+IFilterEngine& CreateFilterEngine(Platform& platform,
+                                  VirtualClock& clock,
+                                  const FilterEngineFactory::CreationParameters& creationParams)
+{
+  bool isCreated = false;
+  platform.CreateFilterEngineAsync(
+      creationParams, [&isCreated](const IFilterEngine& filterEngine) { isCreated = true; });
+
+  while (!isCreated)
+  {
+    if (clock.RunPending() == 0)
+      throw std::runtime_error("Filter engine creation is waiting for a delayed timer");
+  }
+  return platform.GetFilterEngine();
+}
+
+IFileSystem::IOBuffer ReadDataFile(const std::string& fileName)
+{
+  std::ifstream stream("data/" + fileName, std::ios::binary);
+  return IFileSystem::IOBuffer(std::istreambuf_iterator<char>(stream),
+                               std::istreambuf_iterator<char>());
+}
+
+FilterEngineFactory::CreationParameters BenchmarkEngineParameters()
+{
+  FilterEngineFactory::CreationParameters params;
+  params.preconfiguredPrefs
+      .booleanPrefs[FilterEngineFactory::BooleanPrefName::FirstRunSubscriptionAutoselect] = false;
+  params.preconfiguredPrefs
+      .booleanPrefs[FilterEngineFactory::BooleanPrefName::SynchronizationEnabled] = false;
+  return params;
+}
+
+std::unique_ptr<Platform> CreateBenchmarkPlatform(PlatformFactory::CreationParameters&& params)
+{
+  if (!params.fileSystem)
+  {
+    std::unique_ptr<InMemoryFileSystem> fileSystem(new InMemoryFileSystem());
+    for (const std::string fileName : {"patterns.ini", "prefs.json"})
+      fileSystem->Write(fileName, ReadDataFile(fileName), [](const std::string&) {});
+    params.fileSystem = std::move(fileSystem);
+  }
+  if (!params.webRequest)
+    params.webRequest.reset(new NoopWebRequest());
+
+  auto platform = PlatformFactory::CreatePlatform(std::move(params));
+  platform->SetUp();
+  CreateFilterEngine(*platform, BenchmarkEngineParameters());
+  return platform;
+}
+
 ThrowingPlatformCreationParameters::ThrowingPlatformCreationParameters()
 {
   logSystem.reset(new ThrowingLogSystem());
@@ -19,6 +19,8 @@
 
 #include <AdblockPlus.h>
 #include <gtest/gtest.h>
+#include <map>
+#include <mutex>
 #include <thread>
 
 #include "../src/DefaultPlatform.h"
@@ -96,6 +98,68 @@ public:
   static void ProcessImmediateTimers(DelayedTimer::SharedTasks& timerTasks);
 };
 
+// Time source for VirtualTimer. Nothing is run until the test moves the
+// clock, then due callbacks are called on the calling thread in the order of
+// their due time, including the ones scheduled meanwhile. It allows to
+// simulate weeks of synchronization in a few seconds.
+class VirtualClock
+{
+public:
+  typedef AdblockPlus::ITimer::TimerCallback Callback;
+
+  // Starts at the current wall-clock time, so that the timestamps stored by
+  // the synchronizer look realistic.
+  VirtualClock();
+  ~VirtualClock();
+
+  // Milliseconds since epoch.
+  std::chrono::milliseconds Now() const;
+  void Schedule(const std::chrono::milliseconds& timeout, const Callback& callback);
+  size_t PendingCount() const;
+
+  // Calls the callbacks which are due now, returns their number.
+  size_t RunPending();
+
+  // Moves the clock forward calling due callbacks on the way, returns their
+  // number.
+  size_t Advance(const std::chrono::milliseconds& duration);
+
+  // Makes Date.now() in JS return Now() of this clock and replaces
+  // Math.random() with a seeded generator, the downloader uses it to spread
+  // expirations. Only one clock at a time can be installed.
+  void InstallInJsEngine(AdblockPlus::JsEngine& jsEngine);
+
+private:
+  mutable std::mutex mutex;
+  std::chrono::milliseconds now;
+  std::multimap<std::chrono::milliseconds, Callback> tasks;
+};
+
+class VirtualTimer : public AdblockPlus::ITimer
+{
+public:
+  typedef std::shared_ptr<VirtualClock> SharedClock;
+  static std::unique_ptr<AdblockPlus::ITimer> New(SharedClock& clock)
+  {
+    std::unique_ptr<VirtualTimer> result(new VirtualTimer());
+    clock = result->clock;
+    return std::move(result);
+  }
+
+  void SetTimer(const std::chrono::milliseconds& timeout,
+                const TimerCallback& timerCallback) override
+  {
+    clock->Schedule(timeout, timerCallback);
+  }
+
+private:
+  VirtualTimer() : clock(std::make_shared<VirtualClock>())
+  {
+  }
+
+  SharedClock clock;
+};
+
 class ThrowingLogSystem : public AdblockPlus::LogSystem
 {
 public:
@@ -304,6 +368,28 @@ CreateFilterEngine(AdblockPlus::Platform& platform,
                    const AdblockPlus::FilterEngineFactory::CreationParameters& creationParams =
                        AdblockPlus::FilterEngineFactory::CreationParameters());
 
+// Runs the pending callbacks of the virtual clock until the filter engine is
+// created, the clock isn't moved forward.
+AdblockPlus::IFilterEngine&
+CreateFilterEngine(AdblockPlus::Platform& platform,
+                   VirtualClock& clock,
+                   const AdblockPlus::FilterEngineFactory::CreationParameters& creationParams =
+                       AdblockPlus::FilterEngineFactory::CreationParameters());
+
+// Reads a file of the data directory, such as data/patterns.ini.
+AdblockPlus::IFileSystem::IOBuffer ReadDataFile(const std::string& fileName);
+
+// Filter engine parameters of the benchmarks, no subscriptions are added on
+// first run and synchronization is disabled.
+AdblockPlus::FilterEngineFactory::CreationParameters BenchmarkEngineParameters();
+
+// Sets up a platform and creates its filter engine with
+// BenchmarkEngineParameters(). Unless given, the file system holds
+// data/patterns.ini and data/prefs.json and web requests are ignored.
+std::unique_ptr<AdblockPlus::Platform>
+CreateBenchmarkPlatform(AdblockPlus::PlatformFactory::CreationParameters&& params =
+                            AdblockPlus::PlatformFactory::CreationParameters());
+
 class NoopWebRequest : public AdblockPlus::IWebRequest
 {
 public:
@@ -418,6 +504,36 @@ public:
   }
 };
 
+// Serves filter list fixtures keyed by URL, the query string is ignored.
+// Unknown URLs are answered with 404. Responses are passed to the scheduler,
+// e.g. to deliver them on the next tick of a VirtualClock.
+class FixtureWebRequest : public AdblockPlus::IWebRequest
+{
+public:
+  typedef std::function<void()> Task;
+  typedef std::function<void(const Task& task)> Scheduler;
+  typedef std::map<std::string, std::string> Fixtures;
+
+  explicit FixtureWebRequest(const Fixtures& fixtures,
+                             const Scheduler& scheduler = LazyFileSystem::ExecuteImmediately)
+      : fixtures(fixtures), scheduler(scheduler), requestCount(0), responseBytes(0)
+  {
+  }
+
+  void GET(const std::string& url,
+           const AdblockPlus::HeaderList& requestHeaders,
+           const RequestCallback& callback) override;
+
+  void HEAD(const std::string& url,
+            const AdblockPlus::HeaderList& requestHeaders,
+            const RequestCallback& callback) override;
+
+  Fixtures fixtures;
+  Scheduler scheduler;
+  size_t requestCount;
+  size_t responseBytes;
+};
+
 class LazyLogSystem : public AdblockPlus::LogSystem
 {
 public:
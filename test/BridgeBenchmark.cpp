@@ -0,0 +1,165 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "../src/JsContext.h"
+#include "../src/Utils.h"
+#include "BaseJsTest.h"
+
+using namespace AdblockPlus;
+
+namespace
+{
+  // Counts C++ heap allocations of the bridge_benchmarks executable, which
+  // only holds this file's benchmarks. V8 allocates its heap separately and
+  // isn't included.
+  std::atomic<size_t> allocationCount(0);
+
+  const int kIterations = 100000;
+
+  // Runs the operation and prints its time and allocations per call.
+  template<typename Operation> void Measure(const std::string& name, Operation operation)
+  {
+    operation();
+    const size_t allocationsBefore = allocationCount.load();
+    const auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i)
+      operation();
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - started;
+    const size_t allocations = allocationCount.load() - allocationsBefore;
+
+    std::cout << std::left << std::fixed << std::setprecision(1) << std::setw(36) << name << " ; "
+              << std::right << std::setw(10) << elapsed.count() / kIterations << " ns/op ; "
+              << std::setw(6) << static_cast<double>(allocations) / kIterations << " allocs/op"
+              << std::endl;
+  }
+
+  class BridgeBenchmark : public BaseJsTest
+  {
+  };
+}
+
+void* operator new(std::size_t size)
+{
+  ++allocationCount;
+  if (void* pointer = std::malloc(size ? size : 1))
+    return pointer;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+TEST_F(BridgeBenchmark, NewValue)
+{
+  auto& jsEngine = GetJsEngine();
+  const std::string text = "http://example.com/banner.gif";
+  Measure("NewValue(string)", [&]() { jsEngine.NewValue(text); });
+  Measure("NewValue(int64_t)", [&]() { jsEngine.NewValue(static_cast<int64_t>(42)); });
+  Measure("NewValue(bool)", [&]() { jsEngine.NewValue(true); });
+  Measure("NewValue(double)", [&]() { jsEngine.NewValue(0.5); });
+  Measure("NewObject", [&]() { jsEngine.NewObject(); });
+  Measure("NewArray(5 strings)", [&]() { jsEngine.NewArray({"a", "b", "c", "d", "e"}); });
+}
+
+TEST_F(BridgeBenchmark, Properties)
+{
+  auto& jsEngine = GetJsEngine();
+  JsValue object = jsEngine.Evaluate("({url: 'http://example.com/', count: 1})");
+  Measure("GetProperty", [&]() { object.GetProperty("url"); });
+  Measure("GetProperty().AsString", [&]() { object.GetProperty("url").AsString(); });
+  Measure("SetProperty(string)", [&]() { object.SetProperty("url", "http://example.org/"); });
+  Measure("SetProperty(int64_t)", [&]() { object.SetProperty("count", 2); });
+}
+
+TEST_F(BridgeBenchmark, Call)
+{
+  auto& jsEngine = GetJsEngine();
+  JsValue function = jsEngine.Evaluate("(function() { return arguments.length; })");
+  JsValueList oneArgument{jsEngine.NewValue("a")};
+  JsValueList fiveArguments{jsEngine.NewValue("a"),
+                            jsEngine.NewValue(1),
+                            jsEngine.NewValue(true),
+                            jsEngine.NewValue("b"),
+                            jsEngine.NewValue(2)};
+  Measure("Call(0 args)", [&]() { function.Call(); });
+  Measure("Call(1 arg)", [&]() { function.Call(oneArgument); });
+  Measure("Call(5 args)", [&]() { function.Call(fiveArguments); });
+}
+
+TEST_F(BridgeBenchmark, AsList)
+{
+  auto& jsEngine = GetJsEngine();
+  JsValue array = jsEngine.Evaluate("Array.from({length: 1000}, (v, i) => 'item' + i)");
+  Measure("AsList(1000 strings)", [&]() { array.AsList(); });
+}
+
+TEST_F(BridgeBenchmark, ConvertArguments)
+{
+  auto& jsEngine = GetJsEngine();
+  // Measured inside the callback, so that the JS call isn't included.
+  jsEngine.SetGlobalProperty(
+      "measureConvertArguments",
+      jsEngine.NewCallback([](const v8::FunctionCallbackInfo<v8::Value>& arguments) {
+        JsEngine* engine = JsEngine::FromArguments(arguments);
+        Measure("ConvertArguments(3 args)", [&]() { engine->ConvertArguments(arguments); });
+      }));
+  jsEngine.Evaluate("measureConvertArguments('a', 1, true)");
+}
+
+TEST_F(BridgeBenchmark, ScopedWeakValues)
+{
+  auto& jsEngine = GetJsEngine();
+  JsValueList values{jsEngine.NewValue("a"), jsEngine.NewValue(1)};
+  Measure("ScopedWeakValues create/destroy",
+          [&]() { JsEngine::ScopedWeakValues weakValues(&jsEngine, values); });
+}
+
+TEST_F(BridgeBenchmark, JsContext)
+{
+  auto& jsEngine = GetJsEngine();
+  Measure("JsContext", [&]() {
+    const JsContext context(jsEngine.GetIsolate(), *jsEngine.GetContext());
+  });
+}
+
+TEST_F(BridgeBenchmark, Evaluate)
+{
+  auto& jsEngine = GetJsEngine();
+  Measure("Evaluate(short expression)", [&]() { jsEngine.Evaluate("1 + 1"); });
+}
+
+TEST_F(BridgeBenchmark, SplitString)
+{
+  const std::string files = "compat.js info.js io.js prefs.js utils.js api.js init.js";
+  Measure("Utils::SplitString(7 fields)", [&]() { Utils::SplitString(files, ' '); });
+}
@@ -0,0 +1,194 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../src/CompressingFileSystem.h"
+
+#include <gtest/gtest.h>
+
+#include "BaseJsTest.h"
+
+using namespace AdblockPlus;
+
+namespace
+{
+  IFileSystem::IOBuffer ToBuffer(const std::string& content)
+  {
+    return IFileSystem::IOBuffer(content.cbegin(), content.cend());
+  }
+
+  std::string ToString(const IFileSystem::IOBuffer& content)
+  {
+    return std::string(content.cbegin(), content.cend());
+  }
+
+  class CompressingFileSystemTest : public ::testing::Test
+  {
+  protected:
+    InMemoryFileSystem* storage;
+    std::unique_ptr<CompressingFileSystem> fileSystem;
+
+    void SetUp() override
+    {
+      storage = new InMemoryFileSystem();
+      fileSystem.reset(new CompressingFileSystem(FileSystemPtr(storage)));
+    }
+
+    std::string Read(const IFileSystem& fileSystem, const std::string& fileName)
+    {
+      std::string content;
+      fileSystem.Read(
+          fileName,
+          [&content](IFileSystem::IOBuffer&& data) { content = ToString(data); },
+          [](const std::string& error) { FAIL() << error; });
+      return content;
+    }
+
+    void Write(IFileSystem& fileSystem, const std::string& fileName, const std::string& content)
+    {
+      fileSystem.Write(fileName, ToBuffer(content), [](const std::string& error) {
+        EXPECT_EQ("", error);
+      });
+    }
+  };
+}
+
+TEST(CompressionTest, RoundTrip)
+{
+  std::string filters;
+  for (int i = 0; i < 100000; ++i)
+    filters += "||ads" + std::to_string(i % 977) + ".example.com^$third-party\n";
+  std::string binary;
+  for (int i = 0; i < 300000; ++i)
+    binary += static_cast<char>((i * 7919) ^ (i >> 5));
+
+  for (const std::string& content :
+       {std::string(), std::string("a"), std::string(12, 'x'), std::string(13, 'x'),
+        std::string("[Filter]\ntext=||example.com^\n"), filters, binary})
+  {
+    auto compressed = CompressingFileSystem::Compress(ToBuffer(content));
+    IFileSystem::IOBuffer decompressed;
+    ASSERT_TRUE(CompressingFileSystem::Decompress(std::move(compressed), decompressed));
+    EXPECT_EQ(content, ToString(decompressed));
+  }
+
+  EXPECT_LT(CompressingFileSystem::Compress(ToBuffer(filters)).size(), filters.size() / 4);
+}
+
+TEST(CompressionTest, UncompressedDataIsPassedThrough)
+{
+  IFileSystem::IOBuffer decompressed;
+  ASSERT_TRUE(CompressingFileSystem::Decompress(ToBuffer("# Adblock Plus"), decompressed));
+  EXPECT_EQ("# Adblock Plus", ToString(decompressed));
+}
+
+TEST(CompressionTest, CorruptedDataIsRejected)
+{
+  std::string content;
+  for (int i = 0; i < 1000; ++i)
+    content += "text=||example" + std::to_string(i % 10) + ".com^\n";
+  auto compressed = CompressingFileSystem::Compress(ToBuffer(content));
+  IFileSystem::IOBuffer decompressed;
+
+  auto truncated = compressed;
+  truncated.resize(truncated.size() - 3);
+  EXPECT_FALSE(CompressingFileSystem::Decompress(std::move(truncated), decompressed));
+
+  // An offset pointing before the start of the data.
+  auto corrupted = compressed;
+  for (size_t i = 16; i < corrupted.size(); ++i)
+    corrupted[i] = 0xFF;
+  EXPECT_FALSE(CompressingFileSystem::Decompress(std::move(corrupted), decompressed));
+}
+
+TEST(CompressionTest, FilterStorageFiles)
+{
+  EXPECT_TRUE(CompressingFileSystem::IsFilterStorageFile("patterns.ini"));
+  EXPECT_TRUE(CompressingFileSystem::IsFilterStorageFile("patterns-backup3.ini"));
+  EXPECT_TRUE(CompressingFileSystem::IsFilterStorageFile("data/patterns.ini"));
+  EXPECT_FALSE(CompressingFileSystem::IsFilterStorageFile("patterns.ini.journal"));
+  EXPECT_FALSE(CompressingFileSystem::IsFilterStorageFile("prefs.json"));
+  EXPECT_FALSE(CompressingFileSystem::IsFilterStorageFile("data/patterns/prefs.ini"));
+}
+
+TEST_F(CompressingFileSystemTest, CompressesSelectedFiles)
+{
+  std::string content = "[Subscription]\nurl=~user~1\n[Subscription filters]\n";
+  for (int i = 0; i < 100; ++i)
+    content += "||example.com/ad" + std::to_string(i) + "^\n";
+  Write(*fileSystem, "patterns.ini", content);
+  Write(*fileSystem, "prefs.json", "{}");
+
+  EXPECT_LT(Read(*storage, "patterns.ini").size(), content.size());
+  EXPECT_EQ(content, Read(*fileSystem, "patterns.ini"));
+  EXPECT_EQ("{}", Read(*storage, "prefs.json"));
+  EXPECT_EQ("{}", Read(*fileSystem, "prefs.json"));
+
+  // Backups are renamed, the stored data stays the same.
+  fileSystem->Move("patterns.ini", "patterns-backup1.ini", [](const std::string& error) {
+    EXPECT_EQ("", error);
+  });
+  EXPECT_EQ(content, Read(*fileSystem, "patterns-backup1.ini"));
+  bool hasStatRun = false;
+  fileSystem->Stat("patterns-backup1.ini",
+                   [&hasStatRun](const IFileSystem::StatResult& result, const std::string& error) {
+                     EXPECT_TRUE(result.exists);
+                     hasStatRun = true;
+                   });
+  EXPECT_TRUE(hasStatRun);
+}
+
+TEST_F(CompressingFileSystemTest, ReadsUncompressedFiles)
+{
+  Write(*storage, "patterns.ini", "# Adblock Plus preferences\nversion=5");
+  EXPECT_EQ("# Adblock Plus preferences\nversion=5", Read(*fileSystem, "patterns.ini"));
+}
+
+TEST_F(CompressingFileSystemTest, CorruptedFileIsAnError)
+{
+  auto compressed = CompressingFileSystem::Compress(ToBuffer(std::string(1000, 'x')));
+  compressed.resize(compressed.size() - 1);
+  storage->Write("patterns.ini", compressed, [](const std::string& error) {});
+
+  std::string readError;
+  fileSystem->Read(
+      "patterns.ini",
+      [](IFileSystem::IOBuffer&& data) { FAIL() << "Corrupted file was read"; },
+      [&readError](const std::string& error) { readError = error; });
+  EXPECT_NE("", readError);
+}
+
+TEST_F(CompressingFileSystemTest, WritesStreams)
+{
+  std::vector<std::string> errors;
+  auto callback = [&errors](const std::string& error) { errors.push_back(error); };
+  auto stream = fileSystem->OpenWrite("patterns.ini");
+  stream->Write(ToBuffer("[Filter]\n"), callback);
+  stream->Write(ToBuffer("text=||example.com^\n"), callback);
+  stream->Close(callback);
+  EXPECT_EQ(std::vector<std::string>(3), errors);
+  EXPECT_EQ("[Filter]\ntext=||example.com^\n", Read(*fileSystem, "patterns.ini"));
+
+  stream = fileSystem->OpenAppend("patterns.ini");
+  stream->Write(ToBuffer("hitCount=1\n"), callback);
+  stream->Close(callback);
+  EXPECT_EQ("[Filter]\ntext=||example.com^\nhitCount=1\n", Read(*fileSystem, "patterns.ini"));
+
+  stream = fileSystem->OpenWrite("patterns-backup1.ini");
+  stream->Close(callback);
+  EXPECT_EQ("", Read(*fileSystem, "patterns-backup1.ini"));
+  EXPECT_NE("", Read(*storage, "patterns-backup1.ini"));
+}
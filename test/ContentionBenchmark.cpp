@@ -0,0 +1,235 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BaseJsTest.h"
+#include "TraceWorkload.h"
+
+namespace
+{
+  // Each run replays the whole workload this many times.
+  const int kRounds = 3;
+  const int kThreadCounts[] = {1, 2, 4, 8};
+  const auto kUpdateInterval = std::chrono::milliseconds(100);
+  const int kFiltersPerUpdate = 20;
+
+  typedef std::chrono::steady_clock Clock;
+
+  double Microseconds(Clock::duration duration)
+  {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  }
+
+  struct ThreadStats
+  {
+    // Time of each engine call, including the wait for the lock.
+    std::vector<double> latencies;
+    // Time spent acquiring the v8::Locker before each operation.
+    std::vector<double> lockWaits;
+  };
+
+  struct RunResult
+  {
+    int threadCount;
+    double seconds;
+    size_t updates;
+    std::vector<ThreadStats> threads;
+  };
+
+  class ContentionBenchmark
+  {
+  public:
+    ContentionBenchmark()
+    {
+      platform = CreateBenchmarkPlatform();
+      engine = &platform->GetFilterEngine();
+
+      for (const auto& file : GetTraceFiles())
+        LoadTrace(file, workload);
+    }
+
+    bool HasWorkload() const
+    {
+      return !workload.empty();
+    }
+
+    // Replays the workload once from this thread to warm up the JIT.
+    void WarmUp()
+    {
+      ThreadStats stats;
+      for (const auto& operation : workload)
+        Execute(operation, stats);
+    }
+
+    RunResult Run(int threadCount)
+    {
+      RunResult result;
+      result.threadCount = threadCount;
+      result.threads.resize(threadCount);
+      result.updates = 0;
+
+      std::atomic<size_t> cursor(0);
+      const size_t total = workload.size() * kRounds;
+      std::mutex mutex;
+      std::condition_variable finished;
+      bool done = false;
+
+      std::thread updater([&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!finished.wait_for(lock, kUpdateInterval, [&]() { return done; }))
+        {
+          lock.unlock();
+          SimulateUpdate(result.updates++);
+          lock.lock();
+        }
+      });
+
+      const auto started = Clock::now();
+      std::vector<std::thread> workers;
+      for (int i = 0; i < threadCount; ++i)
+      {
+        ThreadStats& stats = result.threads[i];
+        workers.emplace_back([&, total]() {
+          for (size_t next = cursor++; next < total; next = cursor++)
+            Execute(workload[next % workload.size()], stats);
+        });
+      }
+      for (auto& worker : workers)
+        worker.join();
+      result.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+      }
+      finished.notify_one();
+      updater.join();
+      return result;
+    }
+
+  private:
+    std::unique_ptr<AdblockPlus::Platform> platform;
+    AdblockPlus::IFilterEngine* engine;
+    std::vector<TraceOperation> workload;
+
+    AdblockPlus::JsEngine& GetJsEngine()
+    {
+      return static_cast<AdblockPlus::DefaultPlatform*>(platform.get())->GetJsEngine();
+    }
+
+    // The lock wait is probed right before the operation, the engine then
+    // takes the lock for each of its calls as it does for the browser.
+    void Execute(const TraceOperation& operation, ThreadStats& stats)
+    {
+      const auto started = Clock::now();
+      {
+        const v8::Locker locker(GetJsEngine().GetIsolate());
+      }
+      stats.lockWaits.push_back(Microseconds(Clock::now() - started));
+
+      ReplayTraceOperation(*engine, operation);
+      stats.latencies.push_back(Microseconds(Clock::now() - started));
+    }
+
+    // Stands in for a subscription update and the prefs writes which follow
+    // it: a batch of custom filters is added and removed again.
+    void SimulateUpdate(size_t update)
+    {
+      std::vector<AdblockPlus::Filter> filters;
+      for (int i = 0; i < kFiltersPerUpdate; ++i)
+      {
+        filters.push_back(engine->GetFilter("||contention" + std::to_string(update) + "-" +
+                                            std::to_string(i) + ".example^$third-party"));
+        engine->AddFilter(filters.back());
+      }
+
+      AdblockPlus::IFilterEngine::PrefUpdates prefs;
+      prefs.stringPrefs["allowed_connection_type"] = update % 2 ? "wifi" : "";
+      prefs.booleanPrefs["savestats"] = update % 2 != 0;
+      engine->SetPrefs(prefs);
+
+      for (const auto& filter : filters)
+        engine->RemoveFilter(filter);
+    }
+  };
+}
+
+/*
+ * Replays the recorded traces from several threads sharing one filter engine
+ * while another thread keeps changing filters and preferences. Throughput is
+ * compared to a single thread, the time spent waiting for the v8::Locker
+ * shows how much of a call is serialized.
+ */
+TEST(ContentionBenchmark, ReplayTracesFromSeveralThreads)
+{
+  ContentionBenchmark benchmark;
+  ASSERT_TRUE(benchmark.HasWorkload());
+  benchmark.WarmUp();
+
+  double singleThreadThroughput = 0;
+  for (int threadCount : kThreadCounts)
+  {
+    RunResult result = benchmark.Run(threadCount);
+    size_t operations = 0;
+    double lockWaitTotal = 0;
+    double latencyTotal = 0;
+    for (const auto& stats : result.threads)
+    {
+      operations += stats.latencies.size();
+      for (double wait : stats.lockWaits)
+        lockWaitTotal += wait;
+      for (double latency : stats.latencies)
+        latencyTotal += latency;
+    }
+    const double throughput = operations / result.seconds;
+    if (threadCount == 1)
+      singleThreadThroughput = throughput;
+
+    std::cout << std::fixed << std::setprecision(3) << "Threads: " << threadCount
+              << ", ops/s: " << throughput
+              << ", scaling: " << throughput / singleThreadThroughput
+              << ", lock wait: " << (latencyTotal > 0 ? 100 * lockWaitTotal / latencyTotal : 0)
+              << "% of call time, updates: " << result.updates << std::endl;
+    std::cout << std::left << std::setw(8) << "Thread"
+              << " ;      Count ; Median(us) ;    p99(us) ;    Max(us) ;"
+                 " Wait p50(us) ; Wait p99(us)"
+              << std::endl;
+    for (size_t i = 0; i < result.threads.size(); ++i)
+    {
+      auto& latencies = result.threads[i].latencies;
+      auto& lockWaits = result.threads[i].lockWaits;
+      std::sort(latencies.begin(), latencies.end());
+      std::sort(lockWaits.begin(), lockWaits.end());
+      std::cout << std::left << std::setw(8) << i << " ; " << std::right << std::setw(10)
+                << latencies.size() << " ; " << std::setw(10) << Percentile(latencies, 50)
+                << " ; " << std::setw(10) << Percentile(latencies, 99) << " ; " << std::setw(10)
+                << Percentile(latencies, 100) << " ; " << std::setw(12)
+                << Percentile(lockWaits, 50) << " ; " << std::setw(12)
+                << Percentile(lockWaits, 99) << std::endl;
+    }
+  }
+}
@@ -244,6 +244,66 @@ TEST_F(DefaultFileSystemTest, WriteMoveStatRemove)
   EXPECT_TRUE(hasStatRemovedFileRun);
 }
 
+TEST_F(DefaultFileSystemTest, OpenWriteWritesChunks)
+{
+  WriteString("previous contents");
+
+  std::vector<std::string> errors;
+  auto callback = [&errors](const std::string& error) { errors.push_back(error); };
+  auto stream = fileSystem->OpenWrite(testFileName);
+  stream->Write(IFileSystem::IOBuffer{'f', 'o', 'o'}, callback);
+  stream->Write(IFileSystem::IOBuffer{'b', 'a', 'r'}, callback);
+  stream->Close(callback);
+  // Pending writes finish even if the stream goes away.
+  stream.reset();
+  EXPECT_TRUE(errors.empty());
+  for (int i = 0; i < 3; ++i)
+    PumpTask();
+  EXPECT_EQ(std::vector<std::string>(3), errors);
+
+  bool hasReadRun = false;
+  fileSystem->Read(
+      testFileName,
+      [&hasReadRun](IFileSystem::IOBuffer&& content) {
+        EXPECT_EQ("foobar", std::string(content.cbegin(), content.cend()));
+        hasReadRun = true;
+      },
+      [](const std::string& error) { FAIL() << error; });
+  PumpTask();
+  EXPECT_TRUE(hasReadRun);
+
+  fileSystem->Remove(testFileName, [](const std::string& error) {});
+  PumpTask();
+}
+
+TEST_F(DefaultFileSystemTest, OpenAppendKeepsContents)
+{
+  WriteString("previous ");
+
+  std::vector<std::string> errors;
+  auto callback = [&errors](const std::string& error) { errors.push_back(error); };
+  auto stream = fileSystem->OpenAppend(testFileName);
+  stream->Write(IFileSystem::IOBuffer{'f', 'o', 'o'}, callback);
+  stream->Close(callback);
+  for (int i = 0; i < 2; ++i)
+    PumpTask();
+  EXPECT_EQ(std::vector<std::string>(2), errors);
+
+  bool hasReadRun = false;
+  fileSystem->Read(
+      testFileName,
+      [&hasReadRun](IFileSystem::IOBuffer&& content) {
+        EXPECT_EQ("previous foo", std::string(content.cbegin(), content.cend()));
+        hasReadRun = true;
+      },
+      [](const std::string& error) { FAIL() << error; });
+  PumpTask();
+  EXPECT_TRUE(hasReadRun);
+
+  fileSystem->Remove(testFileName, [](const std::string& error) {});
+  PumpTask();
+}
+
 TEST_F(DefaultFileSystemTest, ResetAfterCallbackScheduled)
 {
   AdblockPlus::AppInfo appInfo;
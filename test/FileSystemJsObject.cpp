@@ -22,14 +22,13 @@
 
 using namespace AdblockPlus;
 
-extern std::string jsSources[];
-
 namespace
 {
   class MockFileSystem : public AdblockPlus::IFileSystem
   {
   public:
     bool success;
+    bool readSuccess;
     IOBuffer contentToRead;
     std::string lastWrittenFile;
     IOBuffer lastWrittenContent;
@@ -40,7 +39,7 @@ namespace
     bool statExists;
     int statLastModified;
 
-    MockFileSystem() : success(true)
+    MockFileSystem() : success(true), readSuccess(true)
     {
     }
 
@@ -48,7 +47,7 @@ namespace
               const ReadCallback& callback,
               const Callback& errorCallback) const override
     {
-      if (success)
+      if (success && readSuccess)
         try
         {
           callback(IOBuffer(contentToRead));
@@ -188,6 +187,66 @@ TEST_F(FileSystemJsObjectTest, WriteError)
   ASSERT_NE("", GetJsEngine().Evaluate("error").AsString());
 }
 
+TEST_F(FileSystemJsObjectTest, WriteInChunks)
+{
+  GetJsEngine().Evaluate("let errors = [];"
+                         "let file = _fileSystem.openWrite('foo');"
+                         "_fileSystem.writeChunk(file, 'ba', e => errors.push(e));"
+                         "_fileSystem.writeChunk(file, 'r', e => errors.push(e));"
+                         "_fileSystem.close(file, e => errors.push(e))");
+  ASSERT_EQ("foo", mockFileSystem->lastWrittenFile);
+  ASSERT_EQ((AdblockPlus::IFileSystem::IOBuffer{'b', 'a', 'r'}),
+            mockFileSystem->lastWrittenContent);
+  ASSERT_EQ(",,", GetJsEngine().Evaluate("errors.join()").AsString());
+  ASSERT_ANY_THROW(GetJsEngine().Evaluate("_fileSystem.close(file, () => {})"));
+}
+
+TEST_F(FileSystemJsObjectTest, WriteInChunksError)
+{
+  mockFileSystem->success = false;
+  GetJsEngine().Evaluate("let error = true; let file = _fileSystem.openWrite('foo');"
+                         "_fileSystem.writeChunk(file, 'bar', () => {});"
+                         "_fileSystem.close(file, e => {error = e})");
+  ASSERT_NE("", GetJsEngine().Evaluate("error").AsString());
+}
+
+TEST_F(FileSystemJsObjectTest, AppendInChunks)
+{
+  mockFileSystem->statExists = true;
+  mockFileSystem->contentToRead = {'f', 'o', 'o'};
+  GetJsEngine().Evaluate("let errors = [];"
+                         "let file = _fileSystem.openAppend('foo');"
+                         "_fileSystem.writeChunk(file, 'bar', e => errors.push(e));"
+                         "_fileSystem.close(file, e => errors.push(e))");
+  ASSERT_EQ("foo", mockFileSystem->lastWrittenFile);
+  ASSERT_EQ((AdblockPlus::IFileSystem::IOBuffer{'f', 'o', 'o', 'b', 'a', 'r'}),
+            mockFileSystem->lastWrittenContent);
+  ASSERT_EQ(",", GetJsEngine().Evaluate("errors.join()").AsString());
+}
+
+TEST_F(FileSystemJsObjectTest, AppendToMissingFile)
+{
+  mockFileSystem->statExists = false;
+  mockFileSystem->contentToRead = {'f', 'o', 'o'};
+  GetJsEngine().Evaluate("let file = _fileSystem.openAppend('foo');"
+                         "_fileSystem.writeChunk(file, 'bar', () => {});"
+                         "_fileSystem.close(file, () => {})");
+  ASSERT_EQ((AdblockPlus::IFileSystem::IOBuffer{'b', 'a', 'r'}),
+            mockFileSystem->lastWrittenContent);
+}
+
+TEST_F(FileSystemJsObjectTest, AppendReadError)
+{
+  // The file mustn't be replaced by the appended data if it can't be read.
+  mockFileSystem->statExists = true;
+  mockFileSystem->readSuccess = false;
+  GetJsEngine().Evaluate("let error = ''; let file = _fileSystem.openAppend('foo');"
+                         "_fileSystem.writeChunk(file, 'bar', () => {});"
+                         "_fileSystem.close(file, e => {error = e})");
+  ASSERT_NE("", GetJsEngine().Evaluate("error").AsString());
+  ASSERT_EQ("", mockFileSystem->lastWrittenFile);
+}
+
 TEST_F(FileSystemJsObjectTest, Move)
 {
   GetJsEngine().Evaluate(
@@ -402,11 +461,11 @@ TEST_F(FileSystemJsObjectTest, MoveNonExistingFile)
   mockFileSystem->success = false;
   auto& jsEngine = GetJsEngine();
   const std::vector<std::string> jsFiles = {"compat.js", "io.js"};
-  for (int i = 0; !jsSources[i].empty(); i += 2)
+  for (const JsSource* jsSource = jsSources; jsSource->filename; ++jsSource)
   {
-    if (jsFiles.end() != std::find(jsFiles.begin(), jsFiles.end(), jsSources[i]))
+    if (jsFiles.end() != std::find(jsFiles.begin(), jsFiles.end(), jsSource->filename))
     {
-      jsEngine.Evaluate(jsSources[i + 1], jsSources[i]);
+      jsEngine.Evaluate(*jsSource);
     }
   }
   jsEngine.Evaluate(R"js(
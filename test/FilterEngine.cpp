@@ -15,7 +15,10 @@
  * along with Adblock Plus.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <sstream>
 #include <thread>
 
 #include "FilterEngineTest.h"
@@ -274,6 +277,22 @@ TEST_F(FilterEngineTest, AddRemoveFilters)
   ASSERT_EQ(0u, filterEngine.GetListedFilters().size());
 }
 
+TEST_F(FilterEngineTest, SubscriptionMemoryUsage)
+{
+  auto& filterEngine = GetFilterEngine();
+  const std::string text = "||example.com/banner.gif";
+  filterEngine.AddFilter(filterEngine.GetFilter(text));
+
+  const auto usages = filterEngine.GetSubscriptionMemoryUsage();
+  auto it = std::find_if(usages.begin(), usages.end(), [](const auto& usage) {
+    return usage.filterCount > 0;
+  });
+  ASSERT_TRUE(it != usages.end());
+  EXPECT_EQ(1, it->filterCount);
+  EXPECT_EQ(static_cast<int64_t>(text.size()), it->textBytes);
+  EXPECT_GT(it->estimatedBytes, it->textBytes);
+}
+
 TEST_F(FilterEngineTest, AddedSubscriptionIsEnabled)
 {
   auto subscription = GetFilterEngine().GetSubscription("https://foo/");
@@ -447,6 +466,108 @@ TEST_F(FilterEngineTest, Matches)
   ASSERT_EQ(AdblockPlus::Filter::Type::TYPE_BLOCKING, match12.GetType());
 }
 
+TEST_F(FilterEngineTest, RarelyUsedModulesAreEvaluatedOnDemand)
+{
+  GetFilterEngine();
+  auto evaluationCount = [this](const std::string& filename) {
+    const auto timeline = platform->GetStartupTimeline();
+    return std::count_if(
+        timeline.begin(), timeline.end(), [&filename](const StartupPhase& phase) {
+          return phase.name == "evaluate:" + filename;
+        });
+  };
+  EXPECT_EQ(1, evaluationCount("init.js"));
+  EXPECT_EQ(0, evaluationCount("compose.js"));
+
+  EXPECT_TRUE(GetJsEngine().Evaluate("require('compose')").IsObject());
+  EXPECT_TRUE(GetJsEngine().Evaluate("require('./compose')").IsObject());
+  EXPECT_EQ(1, evaluationCount("compose.js"));
+}
+
+TEST_F(FilterEngineTest, StartupTimeline)
+{
+  auto& filterEngine = GetFilterEngine();
+  auto hasPhase = [this](const std::string& name) {
+    const auto timeline = platform->GetStartupTimeline();
+    return std::any_of(timeline.begin(), timeline.end(), [&name](const StartupPhase& phase) {
+      return phase.name == name;
+    });
+  };
+  // "V8Initializer::Init" is only recorded by the first engine of the process.
+  EXPECT_TRUE(hasPhase("JsEngine::New"));
+  EXPECT_TRUE(hasPhase("evaluate:init.js"));
+  EXPECT_TRUE(hasPhase("initializePrefs"));
+  EXPECT_TRUE(hasPhase("filterEngine.initialize"));
+  EXPECT_TRUE(hasPhase("_init"));
+  EXPECT_FALSE(hasPhase("first Matches"));
+
+  filterEngine.Matches(
+      "http://example.org/foobar.gif", AdblockPlus::IFilterEngine::CONTENT_TYPE_IMAGE, "");
+  filterEngine.Matches(
+      "http://example.org/foobar.gif", AdblockPlus::IFilterEngine::CONTENT_TYPE_IMAGE, "");
+  const auto timeline = platform->GetStartupTimeline();
+  EXPECT_EQ(1, std::count_if(timeline.begin(), timeline.end(), [](const StartupPhase& phase) {
+              return phase.name == "first Matches";
+            }));
+  for (const auto& phase : timeline)
+    EXPECT_LE(std::chrono::microseconds(0), phase.start) << phase.name;
+}
+
+TEST_F(FilterEngineTest, MatchesAsync)
+{
+  auto& filterEngine = GetFilterEngine();
+  filterEngine.AddFilter(filterEngine.GetFilter("adbanner.gif"));
+  IFilterEngine::MatchRequest request;
+  request.url = "http://example.org/adbanner.gif";
+  request.contentTypeMask = IFilterEngine::CONTENT_TYPE_IMAGE;
+  auto match = filterEngine.MatchesAsync(request).get();
+  ASSERT_TRUE(match.IsValid());
+  EXPECT_EQ(AdblockPlus::Filter::Type::TYPE_BLOCKING, match.GetType());
+
+  request.url = "http://example.org/foo.gif";
+  EXPECT_FALSE(filterEngine.MatchesAsync(request).get().IsValid());
+}
+
+TEST_F(FilterEngineTest, MatchesAsyncPrefersDocuments)
+{
+  auto& filterEngine = GetFilterEngine();
+  IFilterEngine::MatchRequest request;
+  request.url = "http://example.org/";
+  request.contentTypeMask = IFilterEngine::CONTENT_TYPE_SCRIPT;
+
+  // Keep the engine thread busy until all requests are queued.
+  Sync queued;
+  filterEngine.MatchesAsync(request, [&queued](const AdblockPlus::Filter&) {
+    queued.WaitFor();
+  });
+
+  std::mutex mutex;
+  std::vector<IFilterEngine::ContentTypeMask> order;
+  Sync done;
+  for (auto contentType : {IFilterEngine::CONTENT_TYPE_PING,
+                           IFilterEngine::CONTENT_TYPE_IMAGE,
+                           IFilterEngine::CONTENT_TYPE_SCRIPT,
+                           IFilterEngine::CONTENT_TYPE_SUBDOCUMENT})
+  {
+    request.contentTypeMask = contentType;
+    filterEngine.MatchesAsync(request, [&, contentType](const AdblockPlus::Filter&) {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(contentType);
+      if (order.size() == 4)
+        done.Set();
+    });
+  }
+  queued.Set();
+  ASSERT_TRUE(done.WaitFor());
+
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(4u, order.size());
+  EXPECT_EQ(IFilterEngine::CONTENT_TYPE_SUBDOCUMENT, order[0]);
+  EXPECT_EQ(IFilterEngine::CONTENT_TYPE_SCRIPT, order[1]);
+  EXPECT_EQ(IFilterEngine::CONTENT_TYPE_PING, order[2]);
+  EXPECT_EQ(IFilterEngine::CONTENT_TYPE_IMAGE, order[3]);
+}
+
 TEST_F(FilterEngineTest, GenericblockHierarchy)
 {
   auto& filterEngine = GetFilterEngine();
@@ -536,6 +657,65 @@ TEST_F(FilterEngineTest, GenericblockMatch)
   EXPECT_FALSE(match2.IsValid()); // Now with genericblock this request is not blocked
 }
 
+TEST_F(FilterEngineTest, GenericblockMatchInFrameContext)
+{
+  auto& filterEngine = GetFilterEngine();
+  filterEngine.AddFilter(filterEngine.GetFilter("/testcasefiles/genericblock/target-generic.jpg"));
+  filterEngine.AddFilter(filterEngine.GetFilter(
+      "/testcasefiles/genericblock/target-notgeneric.jpg$domain=testpages.adblockplus.org"));
+  const std::string urlGeneric =
+      "http://testpages.adblockplus.org/testcasefiles/genericblock/target-generic.jpg";
+  const std::string urlNotGeneric =
+      "http://testpages.adblockplus.org/testcasefiles/genericblock/target-notgeneric.jpg";
+  auto frame = filterEngine.CreateFrameContext(
+      {"http://testpages.adblockplus.org/testcasefiles/genericblock/frame.html",
+       "http://testpages.adblockplus.org/en/exceptions/genericblock/"});
+
+  EXPECT_FALSE(filterEngine.IsContentAllowlisted(IFilterEngine::CONTENT_TYPE_GENERICBLOCK, *frame));
+  auto match = filterEngine.Matches(urlGeneric, IFilterEngine::CONTENT_TYPE_IMAGE, *frame);
+  ASSERT_TRUE(match.IsValid());
+  EXPECT_EQ(AdblockPlus::Filter::Type::TYPE_BLOCKING, match.GetType());
+
+  // The existing frame context picks up the new filter.
+  filterEngine.AddFilter(filterEngine.GetFilter(
+      "@@||testpages.adblockplus.org/en/exceptions/genericblock$genericblock"));
+
+  EXPECT_TRUE(filterEngine.IsContentAllowlisted(IFilterEngine::CONTENT_TYPE_GENERICBLOCK, *frame));
+  match = filterEngine.Matches(urlNotGeneric, IFilterEngine::CONTENT_TYPE_IMAGE, *frame);
+  ASSERT_TRUE(match.IsValid());
+  EXPECT_EQ(AdblockPlus::Filter::Type::TYPE_BLOCKING, match.GetType());
+  EXPECT_FALSE(
+      filterEngine.Matches(urlGeneric, IFilterEngine::CONTENT_TYPE_IMAGE, *frame).IsValid());
+}
+
+TEST_F(FilterEngineTest, DocumentAllowlistingInFrameContext)
+{
+  auto& filterEngine = GetFilterEngine();
+  filterEngine.AddFilter(filterEngine.GetFilter("adbanner.gif"));
+  auto frame = filterEngine.CreateFrameContext(
+      {"http://example.com/frame.html", "http://example.org/index.html"});
+  auto match = filterEngine.Matches(
+      "http://example.net/adbanner.gif", IFilterEngine::CONTENT_TYPE_IMAGE, *frame);
+  ASSERT_TRUE(match.IsValid());
+  EXPECT_EQ(AdblockPlus::Filter::Type::TYPE_BLOCKING, match.GetType());
+
+  filterEngine.AddFilter(filterEngine.GetFilter("@@||example.org^$document"));
+  EXPECT_TRUE(filterEngine.IsContentAllowlisted(IFilterEngine::CONTENT_TYPE_DOCUMENT, *frame));
+  match = filterEngine.Matches(
+      "http://example.net/adbanner.gif", IFilterEngine::CONTENT_TYPE_IMAGE, *frame);
+  ASSERT_TRUE(match.IsValid());
+  EXPECT_EQ(AdblockPlus::Filter::Type::TYPE_EXCEPTION, match.GetType());
+  EXPECT_EQ("@@||example.org^$document", match.GetRaw());
+
+  auto topLevelFrame = filterEngine.CreateFrameContext({});
+  EXPECT_FALSE(
+      filterEngine.IsContentAllowlisted(IFilterEngine::CONTENT_TYPE_DOCUMENT, *topLevelFrame));
+  match = filterEngine.Matches(
+      "http://example.net/adbanner.gif", IFilterEngine::CONTENT_TYPE_IMAGE, *topLevelFrame);
+  ASSERT_TRUE(match.IsValid());
+  EXPECT_EQ(AdblockPlus::Filter::Type::TYPE_BLOCKING, match.GetType());
+}
+
 TEST_F(FilterEngineTest, GenericblockWithDomain)
 {
   auto& filterEngine = GetFilterEngine();
@@ -866,6 +1046,82 @@ TEST_F(FilterEngineTest, AddRemoveFilterEventObserver)
   EXPECT_EQ(raw, observer.lastFilter->GetRaw());
 }
 
+TEST_F(FilterEngineTest, ObserverReceivesOnlyMaskedEvents)
+{
+  auto& filterEngine = GetFilterEngine();
+  FakeFilterEventObserver observer;
+  filterEngine.AddEventObserver(
+      &observer, IFilterEngine::ToEventMask(IFilterEngine::FilterEvent::FILTER_ADDED));
+  filterEngine.AddFilter(filterEngine.GetFilter("foo"));
+  filterEngine.RemoveFilter(filterEngine.GetFilter("foo"));
+  filterEngine.GetSubscription("https://foo/").SetDisabled(true);
+  ASSERT_EQ(1u, observer.filterEvents.size());
+  EXPECT_EQ(IFilterEngine::FilterEvent::FILTER_ADDED, observer.filterEvents[0]);
+  EXPECT_TRUE(observer.subscriptionEvents.empty());
+  filterEngine.RemoveEventObserver(&observer);
+}
+
+TEST_F(FilterEngineTest, QueuedObserverReceivesCoalescedEvents)
+{
+  struct BatchObserver : IFilterEngine::EventObserver
+  {
+    void OnFilterEvents(IFilterEngine::FilterEvent event,
+                        const std::vector<Filter>& filters) override
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const auto& filter : filters)
+        received.push_back(filter.GetRaw());
+      if (received.size() == 3)
+        done.Set();
+    }
+
+    std::mutex mutex;
+    std::vector<std::string> received;
+    Sync done;
+  } observer;
+
+  auto& filterEngine = GetFilterEngine();
+  filterEngine.AddEventObserver(
+      &observer,
+      IFilterEngine::ToEventMask(IFilterEngine::FilterEvent::FILTER_ADDED),
+      IFilterEngine::EventDelivery::QUEUED);
+  filterEngine.AddFilter(filterEngine.GetFilter("foo"));
+  filterEngine.AddFilter(filterEngine.GetFilter("bar"));
+  filterEngine.AddFilter(filterEngine.GetFilter("baz"));
+  ASSERT_TRUE(observer.done.WaitFor());
+  filterEngine.RemoveEventObserver(&observer);
+  EXPECT_EQ(std::vector<std::string>({"foo", "bar", "baz"}), observer.received);
+}
+
+TEST_F(FilterEngineTest, QueuedObserverCanRemoveItself)
+{
+  struct RemovingObserver : IFilterEngine::EventObserver
+  {
+    void OnFilterEvents(IFilterEngine::FilterEvent event,
+                        const std::vector<Filter>& filters) override
+    {
+      filterEngine->RemoveEventObserver(this);
+      ++calls;
+      done.Set();
+    }
+
+    IFilterEngine* filterEngine;
+    std::atomic<int> calls{0};
+    Sync done;
+  } observer;
+
+  auto& filterEngine = GetFilterEngine();
+  observer.filterEngine = &filterEngine;
+  filterEngine.AddEventObserver(
+      &observer,
+      IFilterEngine::ToEventMask(IFilterEngine::FilterEvent::FILTER_ADDED),
+      IFilterEngine::EventDelivery::QUEUED);
+  filterEngine.AddFilter(filterEngine.GetFilter("foo"));
+  ASSERT_TRUE(observer.done.WaitFor());
+  filterEngine.AddFilter(filterEngine.GetFilter("bar"));
+  EXPECT_EQ(1, observer.calls);
+}
+
 TEST_F(FilterEngineTest, AddRemoveSubsciptionEventCallback)
 {
   auto& filterEngine = GetFilterEngine();
@@ -1615,6 +1871,110 @@ TEST_F(FilterEngineWithInMemoryFS, DisableSubscriptionsAutoSelectOnFirstRun)
   EXPECT_FALSE(filterEngine.IsAAEnabled());
 }
 
+TEST_F(FilterEngineWithInMemoryFS, SetPrefsSavesOnce)
+{
+  DelayedTimer::SharedTasks timerTasks;
+  InMemoryFileSystem* fileSystem;
+  PlatformFactory::CreationParameters platformParams;
+  platformParams.timer = DelayedTimer::New(timerTasks);
+  platformParams.fileSystem.reset(fileSystem = new InMemoryFileSystem());
+  InitPlatformAndAppInfo(std::move(platformParams));
+  auto& filterEngine = CreateFilterEngine();
+  // prefs.json is saved with a delay of one second.
+  auto runSaveTimers = [&timerTasks]() {
+    DelayedTimer::ProcessImmediateTimers(timerTasks);
+    std::size_t saveTimers = 0;
+    auto ii = timerTasks->begin();
+    while (ii != timerTasks->end())
+    {
+      if (ii->timeout == std::chrono::milliseconds(1000))
+      {
+        auto callback = ii->callback;
+        ii = timerTasks->erase(ii);
+        callback();
+        ++saveTimers;
+      }
+      else
+        ++ii;
+    }
+    return saveTimers;
+  };
+  runSaveTimers();
+
+  auto readPrefs = [fileSystem]() {
+    std::string content;
+    fileSystem->Read(
+        "prefs.json",
+        [&content](IFileSystem::IOBuffer&& data) { content.assign(data.cbegin(), data.cend()); },
+        [](const std::string& error) {});
+    return content;
+  };
+
+  IFilterEngine::PrefUpdates prefs;
+  prefs.stringPrefs["allowed_connection_type"] = "wifi";
+  prefs.booleanPrefs["savestats"] = true;
+  prefs.intPrefs["patternsbackups"] = 3;
+  filterEngine.SetPrefs(prefs);
+  filterEngine.SetAllowedConnectionType(nullptr);
+  auto allowedConnectionType = filterEngine.GetAllowedConnectionType();
+  EXPECT_FALSE(allowedConnectionType);
+
+  // All changes are written together once the save delay passes.
+  EXPECT_EQ(std::string::npos, readPrefs().find("savestats"));
+  EXPECT_EQ(1u, runSaveTimers());
+  std::string content = readPrefs();
+  EXPECT_NE(std::string::npos, content.find("\"savestats\":true"));
+  EXPECT_NE(std::string::npos, content.find("\"patternsbackups\":3"));
+  EXPECT_EQ(std::string::npos, content.find("wifi"));
+
+  IFilterEngine::PrefUpdates invalidPrefs;
+  invalidPrefs.booleanPrefs["savestats"] = false;
+  invalidPrefs.stringPrefs["no_such_pref"] = "";
+  EXPECT_ANY_THROW(filterEngine.SetPrefs(invalidPrefs));
+  invalidPrefs.stringPrefs.clear();
+  invalidPrefs.stringPrefs["patternsbackups"] = "5";
+  EXPECT_ANY_THROW(filterEngine.SetPrefs(invalidPrefs));
+  EXPECT_EQ(0u, runSaveTimers());
+}
+
+namespace
+{
+  class PrefsRecordingFileSystem : public InMemoryFileSystem
+  {
+  public:
+    explicit PrefsRecordingFileSystem(std::string& prefs) : prefs(prefs)
+    {
+    }
+
+    void Write(const std::string& fileName, const IOBuffer& data, const Callback& callback) override
+    {
+      if (fileName == "prefs.json")
+        prefs.assign(data.cbegin(), data.cend());
+      InMemoryFileSystem::Write(fileName, data, callback);
+    }
+
+  private:
+    std::string& prefs;
+  };
+}
+
+TEST_F(FilterEngineWithInMemoryFS, PendingPrefsAreSavedOnShutdown)
+{
+  // The default timer never fires, so the write only happens on shutdown.
+  std::string prefs;
+  PlatformFactory::CreationParameters platformParams;
+  platformParams.fileSystem.reset(new PrefsRecordingFileSystem(prefs));
+  InitPlatformAndAppInfo(std::move(platformParams));
+  auto& filterEngine = CreateFilterEngine();
+
+  IFilterEngine::PrefUpdates updates;
+  updates.booleanPrefs["savestats"] = true;
+  filterEngine.SetPrefs(updates);
+  EXPECT_EQ(std::string::npos, prefs.find("savestats"));
+  platform.reset();
+  EXPECT_NE(std::string::npos, prefs.find("\"savestats\":true"));
+}
+
 namespace AA_ApiTest
 {
   const std::string kOtherSubscriptionUrl = "https://non-existing-subscription.txt";
@@ -2236,6 +2596,34 @@ TEST_F(FilterEngineTest, GetSnippetScriptBasic)
       script);
 }
 
+TEST_F(FilterEngineTest, GetSnippetScriptWithoutLibrary)
+{
+  auto& filterEngine = GetFilterEngine();
+  filterEngine.AddFilter(filterEngine.GetFilter("test.com#$#log Hello"));
+  EXPECT_EQ("", filterEngine.GetSnippetScript("https://test.com/path"));
+}
+
+TEST_F(FilterEngineTest, GetSnippetScriptUsesLibraryAndCache)
+{
+  auto& filterEngine = GetFilterEngine();
+  filterEngine.SetSnippetLibrary("'use strict';");
+  EXPECT_EQ("", filterEngine.GetSnippetScript("https://test.com/path"));
+
+  // Adding a filter invalidates the cached empty script.
+  filterEngine.AddFilter(filterEngine.GetFilter("test.com#$#log Hello"));
+  auto script = filterEngine.GetSnippetScript("https://test.com/path");
+  EXPECT_EQ(filterEngine.GetSnippetScript("https://test.com/path", "'use strict';"), script);
+  EXPECT_EQ(script, filterEngine.GetSnippetScript("https://test.com/other"));
+  EXPECT_EQ("", filterEngine.GetSnippetScript("https://example.com/path"));
+
+  filterEngine.SetSnippetLibrary("'use strict'; // v2");
+  script = filterEngine.GetSnippetScript("https://test.com/path");
+  EXPECT_NE(std::string::npos, script.find("// v2"));
+
+  filterEngine.RemoveFilter(filterEngine.GetFilter("test.com#$#log Hello"));
+  EXPECT_EQ("", filterEngine.GetSnippetScript("https://test.com/path"));
+}
+
 TEST_F(FilterEngineConfigurableTest, SubscriptionVersion)
 {
   filterList = "[Adblock Plus 2.0]\n!Version: 1234\n||example.com";
@@ -2249,6 +2637,64 @@ TEST_F(FilterEngineConfigurableTest, SubscriptionVersion)
   EXPECT_EQ(1234, subscription.GetVersion());
 }
 
+TEST_F(FilterEngineConfigurableTest, SubscriptionUpdateIsSummarized)
+{
+  filterList = "[Adblock Plus 2.0]\n||example.com\n||foo.com\n||bar.com";
+  auto& engine =
+      ConfigureEngine(AutoselectState::Disabled, SynchronizationState::Enabled, AAState::Disabled);
+  auto subscription = engine.GetSubscription("https://foo.bar");
+  engine.AddSubscription(subscription);
+  ASSERT_EQ(3, subscription.GetFilterCount());
+
+  FakeFilterEventObserver observer;
+  engine.AddEventObserver(&observer);
+
+  filterList = "[Adblock Plus 2.0]\n||example.com\n||foo.com\n||baz.com\n||qux.com";
+  subscription.UpdateFilters();
+  EXPECT_EQ(4, subscription.GetFilterCount());
+  EXPECT_EQ(2, subscription.GetLastUpdateAddedCount());
+  EXPECT_EQ(1, subscription.GetLastUpdateRemovedCount());
+  EXPECT_TRUE(observer.filterEvents.empty());
+  EXPECT_EQ(1, std::count(observer.subscriptionEvents.begin(),
+                          observer.subscriptionEvents.end(),
+                          IFilterEngine::SubscriptionEvent::SUBSCRIPTION_UPDATED));
+  EXPECT_TRUE(engine.Matches("http://baz.com/", IFilterEngine::CONTENT_TYPE_OTHER, "").IsValid());
+  EXPECT_FALSE(engine.Matches("http://bar.com/", IFilterEngine::CONTENT_TYPE_OTHER, "").IsValid());
+
+  // Downloading the same list again isn't reported as an update.
+  observer.Reset();
+  subscription.UpdateFilters();
+  EXPECT_EQ(0, subscription.GetLastUpdateAddedCount());
+  EXPECT_EQ(0, subscription.GetLastUpdateRemovedCount());
+  EXPECT_EQ(0, std::count(observer.subscriptionEvents.begin(),
+                          observer.subscriptionEvents.end(),
+                          IFilterEngine::SubscriptionEvent::SUBSCRIPTION_UPDATED));
+  engine.RemoveEventObserver(&observer);
+}
+
+// lib/filterUpdateRegistration.js relies on the delta core passes with
+// subscription.updated, without it the counts come from a slower fallback.
+TEST_F(FilterEngineConfigurableTest, CoreReportsSubscriptionUpdateDelta)
+{
+  filterList = "[Adblock Plus 2.0]\n||example.com\n||foo.com";
+  auto& engine =
+      ConfigureEngine(AutoselectState::Disabled, SynchronizationState::Enabled, AAState::Disabled);
+  auto subscription = engine.GetSubscription("https://foo.bar");
+  engine.AddSubscription(subscription);
+  ASSERT_EQ(2, subscription.GetFilterCount());
+
+  GetJsEngine().Evaluate(R"(
+    var reportedDelta = null;
+    require("filterNotifier").filterNotifier.on("subscription.updated",
+      (subscription, textDelta) => { reportedDelta = textDelta; });
+  )");
+  filterList = "[Adblock Plus 2.0]\n||example.com\n||baz.com";
+  subscription.UpdateFilters();
+  ASSERT_EQ(2, subscription.GetFilterCount());
+  EXPECT_EQ("||baz.com", GetJsEngine().Evaluate("reportedDelta.added.join()").AsString());
+  EXPECT_EQ("||foo.com", GetJsEngine().Evaluate("reportedDelta.removed.join()").AsString());
+}
+
 TEST_F(FilterEngineConfigurableTest, RemovingCustomFilterWhichsIsAlsoThereInTheListStillMatches)
 {
   const char kTestFilter[] = "&bannerid=";
@@ -2276,3 +2722,94 @@ TEST_F(FilterEngineTest, Stun)
   EXPECT_EQ(IFilterImplementation::TYPE_BLOCKING, result.GetType());
   EXPECT_EQ(raw, result.GetRaw());
 }
+
+TEST_F(FilterEngineWithInMemoryFS, TraceRecordingIsFlushedAsJsonLines)
+{
+  InMemoryFileSystem* fileSystem;
+  PlatformFactory::CreationParameters platformParams;
+  platformParams.fileSystem.reset(fileSystem = new InMemoryFileSystem());
+  InitPlatformAndAppInfo(std::move(platformParams));
+  auto& filterEngine = CreateFilterEngine();
+  filterEngine.AddFilter(filterEngine.GetFilter("adbanner.gif"));
+
+  filterEngine.Matches("http://example.org/ignored.gif", IFilterEngine::CONTENT_TYPE_IMAGE, "");
+  filterEngine.StartTraceRecording(2);
+  filterEngine.Matches("http://example.org/dropped.gif", IFilterEngine::CONTENT_TYPE_IMAGE, "");
+  filterEngine.Matches(
+      "http://example.org/adbanner.gif", IFilterEngine::CONTENT_TYPE_IMAGE, "http://example.org/");
+  filterEngine.IsContentAllowlisted(
+      "http://example.org/", IFilterEngine::CONTENT_TYPE_DOCUMENT, {"http://example.org/"});
+  filterEngine.StopTraceRecording();
+  filterEngine.GetElementHidingStyleSheet("example.org");
+
+  std::string error = "not called";
+  filterEngine.FlushTraceRecording("trace.log", [&error](const std::string& e) { error = e; });
+  EXPECT_EQ("", error);
+
+  std::string content;
+  fileSystem->Read(
+      "trace.log",
+      [&content](IFileSystem::IOBuffer&& data) { content.assign(data.cbegin(), data.cend()); },
+      [](const std::string& error) {});
+  std::vector<std::string> lines;
+  std::istringstream stream(content);
+  for (std::string line; std::getline(stream, line);)
+    lines.push_back(line);
+  ASSERT_EQ(2u, lines.size());
+  EXPECT_EQ(0u,
+            lines[0].find("{\"_fn\":\"matches\",\"url\":\"http://example.org/adbanner.gif\","
+                          "\"content_type\":4,\"document_url\":\"http://example.org/\","
+                          "\"sitekey\":\"\",\"specific_only\":false,\"_res\":\"adbanner.gif\","
+                          "\"_us\":"));
+  EXPECT_EQ(0u,
+            lines[1].find("{\"_fn\":\"is-content-allowlisted\",\"url\":\"http://example.org/\","
+                          "\"content_type\":134217728,\"referrers\":[\"http://example.org/\"],"
+                          "\"sitekey\":\"\",\"_res\":false,\"_us\":"));
+}
+
+class FilterEngineWithVirtualClock : public BaseJsTest
+{
+protected:
+  const std::string kListUrl = "https://example.com/list.txt";
+  VirtualTimer::SharedClock clock;
+  FixtureWebRequest* webRequest;
+
+  void SetUp() override
+  {
+    PlatformFactory::CreationParameters params;
+    params.logSystem.reset(new LazyLogSystem());
+    params.timer = VirtualTimer::New(clock);
+    params.fileSystem.reset(new InMemoryFileSystem());
+    FixtureWebRequest::Fixtures fixtures;
+    fixtures[kListUrl] = "[Adblock Plus 2.0]\n! Expires: 1 days\n||example.com^\n";
+    params.webRequest.reset(
+        webRequest = new FixtureWebRequest(fixtures, [this](const FixtureWebRequest::Task& task) {
+          clock->Schedule(std::chrono::milliseconds::zero(), task);
+        }));
+    params.resourceReader.reset(new DefaultResourceReader());
+    platform = PlatformFactory::CreatePlatform(std::move(params));
+    clock->InstallInJsEngine(GetJsEngine());
+
+    FilterEngineFactory::CreationParameters engineParams;
+    engineParams.preconfiguredPrefs
+        .booleanPrefs[FilterEngineFactory::BooleanPrefName::FirstRunSubscriptionAutoselect] = false;
+    ::CreateFilterEngine(*platform, *clock, engineParams);
+  }
+};
+
+TEST_F(FilterEngineWithVirtualClock, ExpiredSubscriptionIsDownloadedAgain)
+{
+  auto& filterEngine = platform->GetFilterEngine();
+  auto subscription = filterEngine.GetSubscription(kListUrl);
+  filterEngine.AddSubscription(subscription);
+  clock->Advance(std::chrono::hours(1));
+  EXPECT_EQ(1u, webRequest->requestCount);
+  EXPECT_EQ("synchronize_ok", subscription.GetSynchronizationStatus());
+  EXPECT_EQ(1, subscription.GetFilterCount());
+  auto lastDownloadSuccessTime = subscription.GetLastDownloadSuccessTime();
+
+  clock->Advance(std::chrono::hours(24 * 7));
+  EXPECT_LT(1u, webRequest->requestCount);
+  EXPECT_LT(lastDownloadSuccessTime, subscription.GetLastDownloadSuccessTime());
+  EXPECT_EQ(1, subscription.GetFilterCount());
+}
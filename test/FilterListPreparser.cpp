@@ -0,0 +1,48 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../src/FilterListPreparser.h"
+
+#include <gtest/gtest.h>
+
+using namespace AdblockPlus;
+
+TEST(FilterListPreparserTest, IgnoresNonFilterLists)
+{
+  const std::string checksumLine = "\n! Checksum: CRr9mig/29Dr1LjmnQFrGg\n||example.org^\n";
+  EXPECT_EQ(FilterListPreparser::Checksum::NONE, FilterListPreparser::VerifyChecksum(""));
+  EXPECT_EQ(FilterListPreparser::Checksum::NONE,
+            FilterListPreparser::VerifyChecksum("<html></html>" + checksumLine));
+  EXPECT_EQ(FilterListPreparser::Checksum::MISMATCH,
+            FilterListPreparser::VerifyChecksum("[Adblock Plus 2.0]" + checksumLine));
+}
+
+TEST(FilterListPreparserTest, ValidatesChecksum)
+{
+  EXPECT_EQ("CRr9mig/29Dr1LjmnQFrGg",
+            FilterListPreparser::CalculateChecksum("[Adblock Plus 2.0]\n||example.com^\n"));
+
+  EXPECT_EQ(FilterListPreparser::Checksum::NONE,
+            FilterListPreparser::VerifyChecksum("[Adblock Plus 2.0]\n! Title: Test\n||ads.com^\n"));
+  EXPECT_EQ(FilterListPreparser::Checksum::VALID,
+            FilterListPreparser::VerifyChecksum("[Adblock Plus 2.0]\r\n"
+                                                "! Checksum: CRr9mig/29Dr1LjmnQFrGg\r\n"
+                                                "||example.com^\r\n\r\n"));
+  EXPECT_EQ(FilterListPreparser::Checksum::MISMATCH,
+            FilterListPreparser::VerifyChecksum(
+                "[Adblock Plus 2.0]\n! Checksum: CRr9mig/29Dr1LjmnQFrGg\n||example.org^\n"));
+}
@@ -1,11 +1,16 @@
+#include <algorithm>
+#include <cctype>
 #include <cmath>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <map>
 #include <numeric>
 
 #include "../src/DefaultFileSystem.h"
+#include "../src/JsContext.h"
 #include "../src/JsError.h"
 #include "BaseJsTest.h"
+#include "TraceWorkload.h"
 
 class ReadOnlyFileSystem : public AdblockPlus::DefaultFileSystem
 {
@@ -32,14 +37,17 @@ public:
   {
     callback("");
   }
-};
 
-enum class PopupBlockResult
-{
-  NO_RULE,
-  BLOCK_RULE,
-  ALLOW_RULE,
-  DISABLED
+  // The default streams end up in Write().
+  std::unique_ptr<WriteStream> OpenWrite(const std::string& fileName) override
+  {
+    return IFileSystem::OpenWrite(fileName);
+  }
+
+  std::unique_ptr<WriteStream> OpenAppend(const std::string& fileName) override
+  {
+    return IFileSystem::OpenWrite(fileName);
+  }
 };
 
 class ElapsedTime
@@ -109,14 +117,60 @@ struct CallStats
     return StdDeviation() / std::sqrt(double(size));
   }
 
+  double Percentile(double percentile)
+  {
+    std::sort(measurements.begin(), measurements.end());
+    return ::Percentile(measurements, percentile);
+  }
+
+  double Max()
+  {
+    return measurements.empty() ? 0 : *std::max_element(measurements.begin(), measurements.end());
+  }
+
   std::vector<double> measurements;
 };
 
+
+// Counts garbage collections of the measured isolate.
+struct GcStats
+{
+  size_t minorCount = 0;
+  size_t majorCount = 0;
+  CallStats pauses;
+  std::chrono::steady_clock::time_point start;
+
+  static void OnPrologue(v8::Isolate* isolate,
+                         v8::GCType type,
+                         v8::GCCallbackFlags flags,
+                         void* data)
+  {
+    static_cast<GcStats*>(data)->start = std::chrono::steady_clock::now();
+  }
+
+  static void OnEpilogue(v8::Isolate* isolate,
+                         v8::GCType type,
+                         v8::GCCallbackFlags flags,
+                         void* data)
+  {
+    auto* stats = static_cast<GcStats*>(data);
+    if (type == v8::kGCTypeScavenge)
+      ++stats->minorCount;
+    else
+      ++stats->majorCount;
+    stats->pauses.Add(std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - stats->start)
+                          .count());
+  }
+};
+
 class HarnessTest : public ::testing::Test
 {
 protected:
   std::unique_ptr<AdblockPlus::Platform> platform;
+  std::vector<TraceOperation> workload;
   std::map<std::string, CallStats> stats;
+  GcStats gcStats;
 
   void SetUp() override
   {
@@ -151,216 +205,79 @@ protected:
     return platform->GetFilterEngine();
   }
 
-  void MatchFromFile(const std::string& file)
-  {
-    std::ifstream stream(file);
-    std::string line;
-    ASSERT_TRUE(stream.is_open());
-
-    while (std::getline(stream, line))
-      if (!line.empty())
-        MatchRecorded(line);
-  }
-
-  void MatchRecorded(const std::string& json)
+  void LoadTrace(const std::string& file)
   {
-    auto& engine = GetJsEngine();
-    AdblockPlus::JsValue callInfo =
-        engine.Evaluate("str => JSON.parse(str)").Call(engine.NewValue(json));
-
-    std::string fn = callInfo.GetProperty("_fn").AsString();
-
-    if (fn == "check-filter-match")
-      stats[fn].Add(CheckFilterMatch(callInfo));
-    else if (fn == "block-popup")
-      stats[fn].Add(BlockPopup(callInfo));
-    else if (fn == "generate-js-css")
-      stats[fn].Add(GenerateJsCss(callInfo));
+    ASSERT_TRUE(::LoadTrace(file, workload)) << file;
   }
 
-  std::vector<std::string> ToList(const AdblockPlus::JsValue& value) const
-  {
-    std::vector<std::string> res;
-
-    for (const AdblockPlus::JsValue& it : value.AsList())
-      res.push_back(it.AsString());
-
-    return res;
-  }
-
-  double GenerateJsCss(const AdblockPlus::JsValue& info) const
+  void Replay()
   {
+    // Waits for the filter engine before GC callbacks are installed.
     auto& engine = GetFilterEngine();
-    auto url = info.GetProperty("gurl").AsString();
-    auto process_id = info.GetProperty("process_id").AsInt();
-    auto frame_id = info.GetProperty("frame_id").AsInt();
-    auto documentUrls = ToList(info.GetProperty("referrers"));
-    auto sitekey = info.GetProperty("sitekey").AsString();
-    double lasted = 0;
-
+    v8::Isolate* isolate = GetJsEngine().GetIsolate();
     {
-      ElapsedTime timer;
-
-      if (url.rfind("http:", 0) == 0 || url.rfind("https:", 0) == 0)
-      {
-        if (!engine.IsContentAllowlisted(
-                url, AdblockPlus::IFilterEngine::CONTENT_TYPE_DOCUMENT, documentUrls, sitekey) &&
-            !engine.IsContentAllowlisted(
-                url, AdblockPlus::IFilterEngine::CONTENT_TYPE_ELEMHIDE, documentUrls, sitekey))
-        {
-          if (process_id >= 0 && frame_id >= 0)
-          {
-            engine.GetElementHidingEmulationSelectors(url);
-            engine.GetElementHidingStyleSheet(
-                url,
-                engine.IsContentAllowlisted(
-                    url, AdblockPlus::IFilterEngine::CONTENT_TYPE_GENERICHIDE, documentUrls));
-          }
-        }
-      }
-
-      lasted = timer.Microseconds();
+      const AdblockPlus::JsContext context(isolate, *GetJsEngine().GetContext());
+      isolate->AddGCPrologueCallback(GcStats::OnPrologue, &gcStats);
+      isolate->AddGCEpilogueCallback(GcStats::OnEpilogue, &gcStats);
     }
 
-    return lasted;
-  }
-
-  double BlockPopup(const AdblockPlus::JsValue& info) const
-  {
-    auto& engine = GetFilterEngine();
-    auto url = info.GetProperty("url").AsString();
-    auto opener = info.GetProperty("opener").AsString();
-    double lasted = 0;
-
+    const TraceCallObserver observer = [this](const std::string& name, double microseconds) {
+      stats[name].Add(microseconds);
+    };
+    for (const auto& operation : workload)
     {
       ElapsedTime timer;
+      TraceResult result = ReplayTraceOperation(engine, operation, observer);
+      stats[GetTraceOperationName(operation.type)].Add(timer.Microseconds());
 
-      AdblockPlus::Filter filter =
-          engine.Matches(url, AdblockPlus::IFilterEngine::ContentType::CONTENT_TYPE_POPUP, opener);
-      lasted = timer.Microseconds();
+      if (operation.type == TraceOperation::Type::MATCHES)
+        EXPECT_EQ(operation.expectedFilter, result.filter);
+      else if (operation.type != TraceOperation::Type::GENERATE_JS_CSS)
+        EXPECT_EQ(operation.expectedResult, result.result);
     }
 
-    EXPECT_EQ(info.GetProperty("_res").AsInt(), static_cast<int>(lasted));
-    return lasted;
-  }
-
-  double CheckFilterMatch(const AdblockPlus::JsValue& info) const
-  {
-    auto& engine = GetFilterEngine();
-    auto url = info.GetProperty("request_url").AsString();
-    auto documentUrls = ToList(info.GetProperty("referrers"));
-    auto sitekey = info.GetProperty("sitekey").AsString();
-    AdblockPlus::IFilterEngine::ContentType contentTypeMask =
-        static_cast<AdblockPlus::IFilterEngine::ContentType>(
-            info.GetProperty("adblock_resource_type").AsInt());
-    bool decision = false;
-    double lasted = 0;
-
-    {
-      ElapsedTime timer;
-      bool specificOnly = false;
-      AdblockPlus::Filter filter;
-
-      if (!documentUrls.empty())
-      {
-        specificOnly = engine.IsContentAllowlisted(
-            url,
-            AdblockPlus::IFilterEngine::ContentType::CONTENT_TYPE_GENERICBLOCK,
-            documentUrls,
-            sitekey);
-      }
-
-      if (documentUrls.empty())
-        filter = engine.Matches(url, contentTypeMask, "", sitekey, specificOnly);
-      else
-        filter = engine.Matches(url, contentTypeMask, documentUrls.front(), sitekey, specificOnly);
-
-      decision = filter.IsValid() && filter.GetType() != AdblockPlus::Filter::Type::TYPE_EXCEPTION;
-
-      if (decision && engine.IsContentAllowlisted(
-                          url,
-                          AdblockPlus::IFilterEngine::ContentType::CONTENT_TYPE_DOCUMENT,
-                          documentUrls,
-                          sitekey))
-      {
-        decision = false;
-      }
-
-      lasted = timer.Microseconds();
-    }
-
-    EXPECT_EQ(info.GetProperty("_res").AsInt(), decision);
-    return lasted;
+    const AdblockPlus::JsContext context(isolate, *GetJsEngine().GetContext());
+    isolate->RemoveGCPrologueCallback(GcStats::OnPrologue, &gcStats);
+    isolate->RemoveGCEpilogueCallback(GcStats::OnEpilogue, &gcStats);
   }
 
   void ReportPerformance()
   {
-    std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(20) << "Name"
-              << " ; Median(us) ; StdDev(us) ; StdErr(us) ;      Count" << std::endl;
+    std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(28) << "Name"
+              << " ; Median(us) ; StdDev(us) ; StdErr(us) ;    p90(us) ;    p99(us) ;"
+                 "  p99.9(us) ;    Max(us) ;      Count"
+              << std::endl;
 
     for (auto& it : stats)
     {
       const std::string& name = it.first;
       CallStats& cbStats = it.second;
-      std::cout << std::left << std::setw(20) << name << " ; " << std::right << std::setw(10)
+      std::cout << std::left << std::setw(28) << name << " ; " << std::right << std::setw(10)
                 << cbStats.Median() << " ; " << std::setw(10) << cbStats.StdDeviation() << " ; "
                 << std::setw(10) << cbStats.StdError() << " ; " << std::setw(10)
-                << cbStats.measurements.size() << std::endl;
+                << cbStats.Percentile(90) << " ; " << std::setw(10) << cbStats.Percentile(99)
+                << " ; " << std::setw(10) << cbStats.Percentile(99.9) << " ; " << std::setw(10)
+                << cbStats.Max() << " ; " << std::setw(10) << cbStats.measurements.size()
+                << std::endl;
     }
+
+    std::cout << "GC: " << gcStats.minorCount << " minor, " << gcStats.majorCount
+              << " major, pauses median " << gcStats.pauses.Median() << " us, max "
+              << gcStats.pauses.Max() << " us, total "
+              << std::accumulate(gcStats.pauses.measurements.begin(),
+                                 gcStats.pauses.measurements.end(),
+                                 0.0)
+              << " us" << std::endl;
   }
 };
 
 TEST_F(HarnessTest, AllSites)
 {
-  MatchFromFile("data/rec_abudhabi_dubizzle_com.log");
-  MatchFromFile("data/rec_allegro_pl.log");
-  MatchFromFile("data/rec_chron_com.log");
-  MatchFromFile("data/rec_cn_hao123_com.log");
-  MatchFromFile("data/rec_en_wikipedia_org.log");
-  MatchFromFile("data/rec_laodong_vn.log");
-  MatchFromFile("data/rec_news_mail_ru.log");
-  MatchFromFile("data/rec_search_yahoo_com.log");
-  MatchFromFile("data/rec_shopee_vn.log");
-  MatchFromFile("data/rec_shortorial_com.log");
-  MatchFromFile("data/rec_thethao247_vn.log");
-  MatchFromFile("data/rec_vk_com.log");
-  MatchFromFile("data/rec_vnexpress_net.log");
-  MatchFromFile("data/rec_vtv_vn.log");
-  MatchFromFile("data/rec_web_de.log");
-  MatchFromFile("data/rec_www_1tv_ge.log");
-  MatchFromFile("data/rec_www_24h_com_vn.log");
-  MatchFromFile("data/rec_www_amazon_com.log");
-  MatchFromFile("data/rec_www_aparat_com.log");
-  MatchFromFile("data/rec_www_baidu_com.log");
-  MatchFromFile("data/rec_www_bbc_com.log");
-  MatchFromFile("data/rec_www_bedienungsanleitu_ng.log");
-  MatchFromFile("data/rec_www_bing_com.log");
-  MatchFromFile("data/rec_www_boston_com.log");
-  MatchFromFile("data/rec_www_dailymail_co_uk.log");
-  MatchFromFile("data/rec_www_ebay_com.log");
-  MatchFromFile("data/rec_www_flipkart_com.log");
-  MatchFromFile("data/rec_www_forbes_com.log");
-  MatchFromFile("data/rec_www_google_com.log");
-  MatchFromFile("data/rec_www_imdb_com.log");
-  MatchFromFile("data/rec_www_indiatimes_com.log");
-  MatchFromFile("data/rec_www_libero_it.log");
-  MatchFromFile("data/rec_www_manoramaonline_com.log");
-  MatchFromFile("data/rec_www_myauto_ge.log");
-  MatchFromFile("data/rec_www_ndtv_com.log");
-  MatchFromFile("data/rec_www_olx_ro.log");
-  MatchFromFile("data/rec_www_online2pdf_com.log");
-  MatchFromFile("data/rec_www_quora_com.log");
-  MatchFromFile("data/rec_www_reddit_com.log");
-  MatchFromFile("data/rec_www_repubblica_it.log");
-  MatchFromFile("data/rec_www_sapo_pt.log");
-  MatchFromFile("data/rec_www_techradar_com.log");
-  MatchFromFile("data/rec_www_tomsguide_com.log");
-  MatchFromFile("data/rec_www_trustedreviews_com.log");
-  MatchFromFile("data/rec_www_twitch_tv.log");
-  MatchFromFile("data/rec_www_wp_pl.log");
-  MatchFromFile("data/rec_www_xvideos_com.log");
-  MatchFromFile("data/rec_www_youtube_com.log");
-  MatchFromFile("data/rec_yandex_com.log");
+  const auto files = GetTraceFiles();
+  ASSERT_FALSE(files.empty());
+  for (const auto& file : files)
+    LoadTrace(file);
 
+  Replay();
   ReportPerformance();
 }
@@ -0,0 +1,288 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <list>
+
+#include "BaseJsTest.h"
+
+using namespace AdblockPlus;
+
+namespace
+{
+  class IOTest : public BaseJsTest
+  {
+  protected:
+    InMemoryFileSystem* fileSystem;
+    std::list<LazyFileSystem::Task> fileSystemTasks;
+
+    void SetUp() override
+    {
+      ThrowingPlatformCreationParameters params;
+      params.fileSystem.reset(fileSystem = new InMemoryFileSystem(
+                                  [this](const LazyFileSystem::Task& task) {
+                                    fileSystemTasks.push_back(task);
+                                  }));
+      platform = AdblockPlus::PlatformFactory::CreatePlatform(std::move(params));
+
+      auto& jsEngine = GetJsEngine();
+      const std::vector<std::string> jsFiles = {"compat.js", "io.js"};
+      for (const JsSource* jsSource = jsSources; jsSource->filename; ++jsSource)
+      {
+        if (jsFiles.end() != std::find(jsFiles.begin(), jsFiles.end(), jsSource->filename))
+          jsEngine.Evaluate(*jsSource);
+      }
+      jsEngine.Evaluate(R"js(
+        let {IO} = require("io");
+        let result = {};
+        function track(promise)
+        {
+          result = {};
+          promise.then(() => result.done = true, error => result.error = String(error));
+        }
+      )js");
+    }
+
+    bool RunFileSystemTask()
+    {
+      if (fileSystemTasks.empty())
+        return false;
+      auto task = fileSystemTasks.front();
+      fileSystemTasks.pop_front();
+      task();
+      return true;
+    }
+
+    void RunFileSystemTasks()
+    {
+      while (RunFileSystemTask())
+      {
+      }
+    }
+
+    bool IsDone()
+    {
+      return GetJsEngine().Evaluate("result.done === true").AsBool();
+    }
+
+    void StartWriting(const std::string& fileName, const std::vector<std::string>& lines)
+    {
+      auto& jsEngine = GetJsEngine();
+      jsEngine.Evaluate("(fileName, lines) => track(IO.writeToFile(fileName, lines))")
+          .Call({jsEngine.NewValue(fileName), jsEngine.NewArray(lines)});
+    }
+
+    void WriteLines(const std::string& fileName, const std::vector<std::string>& lines)
+    {
+      StartWriting(fileName, lines);
+      RunFileSystemTasks();
+      ASSERT_TRUE(IsDone()) << GetJsEngine().Evaluate("result.error").AsString();
+    }
+
+    std::vector<std::string> ReadLines(const std::string& fileName)
+    {
+      auto& jsEngine = GetJsEngine();
+      jsEngine
+          .Evaluate(R"js((fileName) =>
+          {
+            let lines = [];
+            track(IO.readFromFile(fileName, line => lines.push(line)).then(() =>
+            {
+              result.lines = lines;
+            }));
+          })js")
+          .Call(jsEngine.NewValue(fileName));
+      RunFileSystemTasks();
+      std::vector<std::string> lines;
+      if (!IsDone())
+      {
+        ADD_FAILURE() << jsEngine.Evaluate("result.error").AsString();
+        return lines;
+      }
+      for (const auto& line : jsEngine.Evaluate("result.lines").AsList())
+        lines.push_back(line.AsString());
+      return lines;
+    }
+
+    std::string ReadFile(const std::string& fileName)
+    {
+      std::string content;
+      fileSystem->Read(
+          fileName,
+          [&content](IFileSystem::IOBuffer&& data) { content.assign(data.begin(), data.end()); },
+          [](const std::string& error) { FAIL() << error; });
+      RunFileSystemTasks();
+      return content;
+    }
+
+    void WriteFile(const std::string& fileName, const std::string& content)
+    {
+      fileSystem->Write(fileName,
+                        IFileSystem::IOBuffer(content.begin(), content.end()),
+                        [](const std::string& error) { EXPECT_EQ("", error); });
+      RunFileSystemTasks();
+    }
+
+    bool FileExists(const std::string& fileName)
+    {
+      bool exists = false;
+      fileSystem->Stat(fileName,
+                       [&exists](const IFileSystem::StatResult& result, const std::string&) {
+                         exists = result.exists;
+                       });
+      RunFileSystemTasks();
+      return exists;
+    }
+  };
+}
+
+TEST_F(IOTest, CompleteWriteKeepsOldFileUntilDone)
+{
+  WriteFile("patterns.ini", "[Subscription]\nurl=old\n");
+
+  StartWriting("patterns.ini", {"[Subscription]", "url=new"});
+  while (!IsDone())
+  {
+    EXPECT_EQ("[Subscription]\nurl=old\n", ReadFile("patterns.ini"));
+    ASSERT_TRUE(RunFileSystemTask());
+  }
+  EXPECT_EQ("[Subscription]\nurl=new\n", ReadFile("patterns.ini"));
+  EXPECT_FALSE(FileExists("patterns.tmp.ini"));
+}
+
+TEST_F(IOTest, CompleteWriteIsDroppedIfStorageChanges)
+{
+  WriteFile("patterns.ini", "[Subscription]\nurl=old\n");
+
+  StartWriting("patterns.ini", {"[Subscription]", "url=new"});
+  GetJsEngine().Evaluate("IO.notifyStorageChange()");
+  RunFileSystemTasks();
+  ASSERT_TRUE(IsDone());
+  EXPECT_EQ("[Subscription]\nurl=old\n", ReadFile("patterns.ini"));
+  EXPECT_FALSE(FileExists("patterns.tmp.ini"));
+
+  WriteLines("patterns.ini", {"[Subscription]", "url=new"});
+  EXPECT_EQ("[Subscription]\nurl=new\n", ReadFile("patterns.ini"));
+}
+
+TEST_F(IOTest, ChangesAreJournaled)
+{
+  WriteLines("patterns.ini", {"[Subscription]", "url=a", "[Subscription filters]", "||a.com^",
+                              "[Subscription]", "url=b"});
+  EXPECT_FALSE(FileExists("patterns.ini.journal"));
+
+  // Subscription b moves to the front, the filters of a change.
+  const std::vector<std::string> lines = {"[Subscription]", "url=b", "[Subscription]", "url=a",
+                                          "[Subscription filters]", "||a.com^", "||b.com^"};
+  WriteLines("patterns.ini", lines);
+  EXPECT_EQ("[Subscription]\nurl=a\n[Subscription filters]\n||a.com^\n[Subscription]\nurl=b\n",
+            ReadFile("patterns.ini"));
+  EXPECT_TRUE(FileExists("patterns.ini.journal"));
+  EXPECT_EQ(lines, ReadLines("patterns.ini"));
+
+  // Saving unchanged content doesn't touch the journal.
+  std::string journal = ReadFile("patterns.ini.journal");
+  WriteLines("patterns.ini", lines);
+  EXPECT_EQ(journal, ReadFile("patterns.ini.journal"));
+  EXPECT_EQ(lines, ReadLines("patterns.ini"));
+}
+
+TEST_F(IOTest, LargeJournalIsCompacted)
+{
+  std::vector<std::string> lines = {"[Subscription]", "url=a", "[Subscription filters]"};
+  WriteLines("patterns.ini", lines);
+
+  // Each save journals the whole filters section, which soon exceeds the
+  // 16 KiB limit.
+  bool wasCompacted = false;
+  for (int i = 0; i < 20; i++)
+  {
+    lines.push_back(std::string(1000, 'a' + i));
+    WriteLines("patterns.ini", lines);
+    if (!FileExists("patterns.ini.journal"))
+      wasCompacted = true;
+  }
+  EXPECT_TRUE(wasCompacted);
+  EXPECT_FALSE(FileExists("patterns.ini.journal.old"));
+  EXPECT_FALSE(FileExists("patterns.tmp.ini"));
+  EXPECT_EQ(lines, ReadLines("patterns.ini"));
+}
+
+TEST_F(IOTest, IncompleteBatchIsDroppedAndCompacted)
+{
+  const std::vector<std::string> first = {"[Subscription]", "url=a", "[Subscription filters]",
+                                          "||a.com^"};
+  WriteLines("patterns.ini", first);
+  const std::vector<std::string> second = {"[Subscription]", "url=a", "[Subscription filters]",
+                                           "||a.com^", "||b.com^"};
+  WriteLines("patterns.ini", second);
+  std::string journal = ReadFile("patterns.ini.journal");
+  WriteLines("patterns.ini",
+             {"[Subscription]", "url=a", "[Subscription filters]", "||c.com^", "||d.com^"});
+
+  // The last save was interrupted in the middle of the filters.
+  std::string lastBatch = ReadFile("patterns.ini.journal").substr(journal.size());
+  WriteFile("patterns.ini.journal", journal + lastBatch.substr(0, lastBatch.find("||d")));
+  EXPECT_EQ(second, ReadLines("patterns.ini"));
+
+  // The next save doesn't append to the broken journal.
+  const std::vector<std::string> third = {"[Subscription]", "url=a", "[Subscription filters]",
+                                          "||e.com^"};
+  WriteLines("patterns.ini", third);
+  EXPECT_FALSE(FileExists("patterns.ini.journal"));
+  EXPECT_EQ(third, ReadLines("patterns.ini"));
+}
+
+TEST_F(IOTest, InterruptedCompleteWriteIsFinished)
+{
+  // The new file was written and the journal renamed, but the new file
+  // didn't replace the old one.
+  WriteFile("patterns.ini", "[Subscription]\nurl=old\n");
+  WriteFile("patterns.tmp.ini", "[Subscription]\nurl=new\n");
+  WriteFile("patterns.ini.journal.old", "");
+  EXPECT_EQ((std::vector<std::string>{"[Subscription]", "url=new"}), ReadLines("patterns.ini"));
+  EXPECT_FALSE(FileExists("patterns.tmp.ini"));
+  EXPECT_FALSE(FileExists("patterns.ini.journal.old"));
+
+  // The journal wasn't renamed yet, the new file may be incomplete.
+  WriteFile("patterns.tmp.ini", "[Subscription]\nurl=incomplete\n");
+  WriteFile("patterns.ini.journal.old", "");
+  WriteFile("patterns.ini.journal", "");
+  EXPECT_EQ((std::vector<std::string>{"[Subscription]", "url=new"}), ReadLines("patterns.ini"));
+  EXPECT_FALSE(FileExists("patterns.tmp.ini"));
+}
+
+TEST_F(IOTest, JournalIsMovedAndRemovedWithFile)
+{
+  const std::vector<std::string> lines = {"[Subscription]", "url=b"};
+  WriteLines("patterns.ini", {"[Subscription]", "url=a"});
+  WriteLines("patterns.ini", lines);
+  ASSERT_TRUE(FileExists("patterns.ini.journal"));
+
+  GetJsEngine().Evaluate("track(IO.renameFile('patterns.ini', 'patterns-backup.ini'))");
+  RunFileSystemTasks();
+  ASSERT_TRUE(IsDone());
+  EXPECT_FALSE(FileExists("patterns.ini.journal"));
+  EXPECT_TRUE(FileExists("patterns-backup.ini.journal"));
+  EXPECT_EQ(lines, ReadLines("patterns-backup.ini"));
+
+  GetJsEngine().Evaluate("track(IO.removeFile('patterns-backup.ini'))");
+  RunFileSystemTasks();
+  ASSERT_TRUE(IsDone());
+  EXPECT_FALSE(FileExists("patterns-backup.ini"));
+  EXPECT_FALSE(FileExists("patterns-backup.ini.journal"));
+}
@@ -17,6 +17,7 @@
 
 #include <stdexcept>
 
+#include "../src/Utils.h"
 #include "BaseJsTest.h"
 
 using namespace AdblockPlus;
@@ -44,6 +45,22 @@ TEST_F(JsEngineTest, CompileTimeExceptionIsThrown)
   ASSERT_THROW(GetJsEngine().Evaluate("'foo'bar'"), std::runtime_error);
 }
 
+TEST_F(JsEngineTest, EvaluateJsSource)
+{
+  static const char source[] = "function answer() { return 42; }";
+  const JsSource jsSource = {"answer.js", source, sizeof(source) - 1};
+  GetJsEngine().Evaluate(jsSource);
+  auto result = GetJsEngine().Evaluate("answer()");
+  ASSERT_TRUE(result.IsNumber());
+  ASSERT_EQ(42, result.AsInt());
+}
+
+TEST_F(JsEngineTest, EmbeddedLibraryScriptsAreAscii)
+{
+  for (const JsSource* jsSource = jsSources; jsSource->filename; ++jsSource)
+    EXPECT_TRUE(Utils::IsAscii(jsSource->source, jsSource->sourceLength)) << jsSource->filename;
+}
+
 TEST_F(JsEngineTest, ValueCreation)
 {
   auto value = GetJsEngine().NewValue("foo");
@@ -174,6 +191,32 @@ TEST_F(JsEngineTest, EventCallbacks)
   ASSERT_FALSE(callbackCalled);
 }
 
+TEST_F(JsEngineTest, BackgroundTaskIsDeferredWhileForegroundWorkIsPending)
+{
+  DelayedTimer::SharedTasks timerTasks;
+  ThrowingPlatformCreationParameters params;
+  params.timer = DelayedTimer::New(timerTasks);
+  platform = PlatformFactory::CreatePlatform(std::move(params));
+  auto& jsEngine = GetJsEngine();
+
+  int runs = 0;
+  jsEngine.RunBackgroundTask([&runs] { ++runs; });
+  EXPECT_EQ(1, runs);
+  EXPECT_TRUE(timerTasks->empty());
+
+  jsEngine.BeginForegroundWork();
+  jsEngine.RunBackgroundTask([&runs] { ++runs; });
+  EXPECT_EQ(1, runs);
+  ASSERT_EQ(1u, timerTasks->size());
+
+  jsEngine.EndForegroundWork();
+  auto task = timerTasks->front();
+  timerTasks->pop_front();
+  task.callback();
+  EXPECT_EQ(2, runs);
+  EXPECT_TRUE(timerTasks->empty());
+}
+
 TEST_F(JsEngineTest, GlobalPropertyTest)
 {
   auto& jsEngine = GetJsEngine();
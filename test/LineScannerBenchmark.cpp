@@ -0,0 +1,102 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../src/Utils.h"
+
+using namespace AdblockPlus;
+
+namespace
+{
+  const int kIterations = 50;
+
+  std::string ReadPatterns()
+  {
+    std::ifstream stream("data/patterns.ini", std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+
+  // Byte by byte scan, the way lines were split before Utils::FindLineBreak().
+  const char* FindLineBreakBytewise(const char* begin, const char* end, bool* isAscii)
+  {
+    for (; begin != end && *begin != '\n' && *begin != '\r'; ++begin)
+    {
+      if (static_cast<unsigned char>(*begin) & 0x80)
+        *isAscii = false;
+    }
+    return begin;
+  }
+
+  template<typename Scan> double MeasureThroughput(const std::string& text, Scan scan)
+  {
+    size_t lines = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i)
+    {
+      const char* end = text.data() + text.size();
+      for (const char* position = text.data(); position != end;)
+      {
+        bool isAscii = true;
+        position = scan(position, end, &isAscii);
+        lines += isAscii;
+        while (position != end && (*position == '\n' || *position == '\r'))
+          ++position;
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    EXPECT_GT(lines, 0u);
+    return text.size() * kIterations / elapsed.count() / (1024 * 1024);
+  }
+}
+
+/*
+ * Compares splitting data/patterns.ini into lines with the vectorized
+ * scanner against a byte by byte loop.
+ */
+TEST(LineScannerBenchmark, SplitPatternsIni)
+{
+  std::string text = ReadPatterns();
+  ASSERT_FALSE(text.empty());
+
+  double bytewise = MeasureThroughput(text, FindLineBreakBytewise);
+  double vectorized = MeasureThroughput(
+      text, [](const char* begin, const char* end, bool* isAscii) {
+        return Utils::FindLineBreak(begin, end, isAscii);
+      });
+
+  auto started = std::chrono::steady_clock::now();
+  size_t fields = 0;
+  for (int i = 0; i < kIterations; ++i)
+    fields += Utils::SplitString(text, '\n').size();
+  std::chrono::duration<double> splitElapsed = std::chrono::steady_clock::now() - started;
+  EXPECT_GT(fields, 0u);
+
+  std::cout << std::fixed << std::setprecision(1) << "Input size(KiB)        : "
+            << text.size() / 1024 << std::endl
+            << "Bytewise(MiB/s)        : " << bytewise << std::endl
+            << "FindLineBreak(MiB/s)   : " << vectorized << std::endl
+            << "SplitString(MiB/s)     : "
+            << text.size() * kIterations / splitElapsed.count() / (1024 * 1024) << std::endl;
+}
@@ -0,0 +1,177 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "../src/JsContext.h"
+#include "BaseJsTest.h"
+
+namespace
+{
+  // Sizes of the synthetic lists added on top of data/patterns.ini.
+  const int kListSizes[] = {10000, 50000, 100000};
+  const std::string kListUrlPrefix = "https://example.com/synthetic-";
+
+  // Every list has its own filters, so that no filter is shared.
+  std::string GenerateFilterList(const std::string& prefix, int filterCount)
+  {
+    std::string list = "[Adblock Plus 2.0]\n! Expires: 4 days\n";
+    for (int i = 0; i < filterCount; ++i)
+    {
+      const std::string id = prefix + "-" + std::to_string(i);
+      switch (i % 4)
+      {
+      case 0:
+        list += "||ads" + id + ".example.com^$third-party\n";
+        break;
+      case 1:
+        list += "/banner" + id + "/*$image\n";
+        break;
+      case 2:
+        list += "example" + id + ".com##.ad-" + id + "\n";
+        break;
+      default:
+        list += "@@||cdn" + id + ".example.net^$script\n";
+        break;
+      }
+    }
+    return list;
+  }
+
+  class SyntheticResourceReader : public AdblockPlus::IResourceReader
+  {
+  public:
+    void ReadPreloadedFilterList(const std::string& url,
+                                 const ReadCallback& doneCallback) const override
+    {
+      std::string list;
+      if (url.compare(0, kListUrlPrefix.size(), kListUrlPrefix) == 0)
+      {
+        const std::string size = url.substr(kListUrlPrefix.size());
+        list = GenerateFilterList(size, std::stoi(size));
+      }
+      doneCallback(std::make_unique<AdblockPlus::StringPreloadedFilterResponse>(list));
+    }
+  };
+
+  // Resident set size of the process, 0 where it isn't known.
+  size_t GetResidentSetSize()
+  {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t residentPages = 0;
+    if (statm >> pages >> residentPages)
+      return residentPages * sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+  }
+
+  double Megabytes(size_t bytes)
+  {
+    return bytes / (1024.0 * 1024.0);
+  }
+
+  int GetTotalFilterCount(AdblockPlus::IFilterEngine& engine)
+  {
+    int count = 0;
+    for (const auto& usage : engine.GetSubscriptionMemoryUsage())
+      count += usage.filterCount;
+    return count;
+  }
+}
+
+/*
+ * Loads data/patterns.ini and then synthetic lists of increasing size and
+ * reports the memory used after a full garbage collection. Bytes per filter
+ * of the first row include the engine itself, later rows only count the
+ * filters added since the previous row.
+ */
+TEST(MemoryBenchmark, FootprintPerFilter)
+{
+  AdblockPlus::PlatformFactory::CreationParameters params;
+  params.resourceReader.reset(new SyntheticResourceReader());
+  auto platform = CreateBenchmarkPlatform(std::move(params));
+  auto& engine = platform->GetFilterEngine();
+  auto& jsEngine = static_cast<AdblockPlus::DefaultPlatform*>(platform.get())->GetJsEngine();
+
+  std::cout << std::left << std::setw(24) << "List"
+            << " ;    Filters ; Heap used(MB) ; External(MB) ;    RSS(MB) ; Bytes/filter"
+            << std::endl;
+
+  size_t previousHeapUsed = 0;
+  int previousFilterCount = 0;
+  auto report = [&](const std::string& name) {
+    v8::HeapStatistics heap;
+    {
+      const AdblockPlus::JsContext context(jsEngine.GetIsolate(), *jsEngine.GetContext());
+      jsEngine.GetIsolate()->LowMemoryNotification();
+      jsEngine.GetIsolate()->GetHeapStatistics(&heap);
+    }
+    const int filterCount = GetTotalFilterCount(engine);
+    const int addedFilters = filterCount - previousFilterCount;
+    const double bytesPerFilter =
+        addedFilters > 0
+            ? (static_cast<double>(heap.used_heap_size()) - previousHeapUsed) / addedFilters
+            : 0;
+    std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(24) << name
+              << " ; " << std::right << std::setw(10) << filterCount << " ; " << std::setw(13)
+              << Megabytes(heap.used_heap_size()) << " ; " << std::setw(12)
+              << Megabytes(heap.external_memory()) << " ; " << std::setw(10)
+              << Megabytes(GetResidentSetSize()) << " ; " << std::setw(12) << bytesPerFilter
+              << std::endl;
+    previousHeapUsed = heap.used_heap_size();
+    previousFilterCount = filterCount;
+  };
+
+  report("patterns.ini");
+  ASSERT_GT(previousFilterCount, 0);
+
+  for (int size : kListSizes)
+  {
+    auto subscription = engine.GetSubscription(kListUrlPrefix + std::to_string(size));
+    engine.AddSubscription(subscription);
+    const auto started = std::chrono::steady_clock::now();
+    while (subscription.GetFilterCount() < size &&
+           std::chrono::steady_clock::now() - started < std::chrono::minutes(2))
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_GE(subscription.GetFilterCount(), size);
+    report("+" + std::to_string(size) + " synthetic");
+  }
+
+  std::cout << std::endl
+            << std::left << std::setw(64) << "Subscription"
+            << " ;    Filters ;  Text(MB) ; Estimated(MB)" << std::endl;
+  for (const auto& usage : engine.GetSubscriptionMemoryUsage())
+  {
+    std::cout << std::left << std::setw(64) << usage.url << " ; " << std::right << std::setw(10)
+              << usage.filterCount << " ; " << std::setw(9) << Megabytes(usage.textBytes)
+              << " ; " << std::setw(13) << Megabytes(usage.estimatedBytes) << std::endl;
+  }
+}
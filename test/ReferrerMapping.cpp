@@ -17,6 +17,7 @@
 
 #include <AdblockPlus.h>
 #include <gtest/gtest.h>
+#include <thread>
 
 TEST(ReferrerMappingTest, EmptyReferrerChain)
 {
@@ -79,3 +80,63 @@ TEST(ReferrerMappingTest, CacheOnlyFiveUrls)
   ASSERT_EQ("sixth", referrerChain[3]);
   ASSERT_EQ("seventh", referrerChain[4]);
 }
+
+TEST(ReferrerMappingTest, ReaddingUrlRefreshesIt)
+{
+  AdblockPlus::ReferrerMapping referrerMapping(2);
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("third", "second");
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("fourth", "third");
+  std::vector<std::string> referrerChain = referrerMapping.BuildReferrerChain("third");
+  ASSERT_EQ(0u, referrerChain.size());
+  referrerChain = referrerMapping.BuildReferrerChain("second");
+  ASSERT_EQ(1u, referrerChain.size());
+  ASSERT_EQ("first", referrerChain[0]);
+}
+
+TEST(ReferrerMappingTest, ChangedReferrerUpdatesChain)
+{
+  AdblockPlus::ReferrerMapping referrerMapping;
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("third", "second");
+  std::vector<std::string> referrerChain = referrerMapping.BuildReferrerChain("third");
+  ASSERT_EQ(2u, referrerChain.size());
+  referrerMapping.Add("second", "other");
+  referrerChain = referrerMapping.BuildReferrerChain("third");
+  ASSERT_EQ(2u, referrerChain.size());
+  ASSERT_EQ("other", referrerChain[0]);
+  ASSERT_EQ("second", referrerChain[1]);
+  referrerMapping.Add("first", "zeroth");
+  referrerMapping.Add("other", "first");
+  referrerChain = referrerMapping.BuildReferrerChain("third");
+  ASSERT_EQ(4u, referrerChain.size());
+  ASSERT_EQ("zeroth", referrerChain[0]);
+  ASSERT_EQ("first", referrerChain[1]);
+}
+
+TEST(ReferrerMappingTest, ReferrerLoop)
+{
+  AdblockPlus::ReferrerMapping referrerMapping;
+  referrerMapping.Add("first", "second");
+  referrerMapping.Add("second", "first");
+  std::vector<std::string> referrerChain = referrerMapping.BuildReferrerChain("first");
+  ASSERT_EQ(10u, referrerChain.size());
+  ASSERT_EQ("second", referrerChain[9]);
+  ASSERT_EQ("first", referrerChain[8]);
+}
+
+TEST(ReferrerMappingTest, ConcurrentChainBuilding)
+{
+  AdblockPlus::ReferrerMapping referrerMapping;
+  referrerMapping.Add("second", "first");
+  referrerMapping.Add("third", "second");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+    threads.emplace_back([&referrerMapping] {
+      for (int j = 0; j < 1000; ++j)
+        ASSERT_EQ(2u, referrerMapping.BuildReferrerChain("third").size());
+    });
+  for (auto& thread : threads)
+    thread.join();
+}
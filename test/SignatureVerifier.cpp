@@ -0,0 +1,65 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../src/SignatureVerifier.h"
+
+#include <gtest/gtest.h>
+
+using namespace AdblockPlus;
+
+namespace
+{
+  const std::string publicKey =
+      "MIGfMA0GCSqGSIb3DQEBAQUAA4GNADCBiQKBgQDDVCi8kdtqpW/CmStdYNj0YAvbEsO8VHy1CbUp2eqCpcPDTg8BxJ"
+      "AvRAsjXcclVBAhKmNzFRZXs4iMrgHP/zP/+zP74Y7cJmclrCws2wsVSh/eEqLVlMCSoIVf6JQtmNP0lGu/6N5OWdEp"
+      "s6/t/UMFSso6pfzVfrmyW3SliMJaTwIDAQAB";
+  // Signature of "hello\0host\0ua".
+  const std::string signature =
+      "FFTb0VPXGj5tFZTJXasNROAk5NUQSu7Il+SYOBHaSY0q1stRytpCqVBofyQ6tt4FyADd3/iaWgKAd2NXVm48M3sZu"
+      "cLQ6Vk3BoU+dIDxytwkppxgkqsFHhnEMuDpuGbI0jhXgHXQzudVeVQLlkrPFEQylhypcq4dCocPxWFc8LA=";
+}
+
+TEST(SignatureVerifierTest, VerifiesRsaSha1Signature)
+{
+  EXPECT_TRUE(
+      SignatureVerifier::VerifyRsaSha1(publicKey, signature, std::string("hello\0host\0ua", 13)));
+  EXPECT_FALSE(
+      SignatureVerifier::VerifyRsaSha1(publicKey, signature, std::string("hello\0host\0ub", 13)));
+  EXPECT_FALSE(SignatureVerifier::VerifyRsaSha1(publicKey, signature, "hello"));
+}
+
+TEST(SignatureVerifierTest, RejectsMalformedArguments)
+{
+  std::string data("hello\0host\0ua", 13);
+  EXPECT_FALSE(SignatureVerifier::VerifyRsaSha1("", "", data));
+  EXPECT_FALSE(SignatureVerifier::VerifyRsaSha1(publicKey.substr(0, 40), signature, data));
+  EXPECT_FALSE(SignatureVerifier::VerifyRsaSha1(publicKey, signature.substr(4), data));
+  EXPECT_FALSE(SignatureVerifier::VerifyRsaSha1(publicKey, "!" + signature.substr(1), data));
+  EXPECT_FALSE(SignatureVerifier::VerifyRsaSha1(signature, publicKey, data));
+}
+
+TEST(SignatureVerifierTest, CachedResultsStayCorrect)
+{
+  SignatureVerifier verifier(1);
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_TRUE(verifier.Verify(publicKey, signature, "hello", "host", "ua"));
+    EXPECT_FALSE(verifier.Verify(publicKey, signature, "hello", "host", "ub"));
+    EXPECT_TRUE(verifier.Verify(publicKey, signature, "hello", "host", "ua"));
+    EXPECT_TRUE(verifier.Verify(publicKey, signature, "hello", "host", "ua"));
+  }
+}
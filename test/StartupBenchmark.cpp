@@ -0,0 +1,78 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BaseJsTest.h"
+
+namespace
+{
+  const int kWarmStarts = 5;
+
+  // Starts a platform with the filter lists of data/patterns.ini and returns
+  // its timeline once the first Matches() call returned.
+  AdblockPlus::StartupTimeline Start()
+  {
+    auto platform = CreateBenchmarkPlatform();
+    platform->GetFilterEngine().Matches("http://ads.example.com/banner.gif",
+                                        AdblockPlus::IFilterEngine::CONTENT_TYPE_IMAGE,
+                                        "http://example.org/");
+    return platform->GetStartupTimeline();
+  }
+
+  double Milliseconds(std::chrono::microseconds duration)
+  {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  }
+}
+
+/*
+ * Measures the startup phases reported by Platform::GetStartupTimeline().
+ * The first start in the process is a cold start which includes the V8
+ * initialization, so run this benchmark on its own. Warm starts create a new
+ * platform each time and are reported as medians.
+ */
+TEST(StartupBenchmark, ColdAndWarmStarts)
+{
+  const AdblockPlus::StartupTimeline cold = Start();
+  ASSERT_FALSE(cold.empty());
+
+  std::map<std::string, std::vector<double>> warm;
+  for (int i = 0; i < kWarmStarts; ++i)
+  {
+    for (const auto& phase : Start())
+      warm[phase.name].push_back(Milliseconds(phase.duration));
+  }
+
+  std::cout << std::left << std::setw(32) << "Phase"
+            << " ;  Start(ms) ;   Cold(ms) ; Warm median(ms)" << std::endl;
+  for (const auto& phase : cold)
+  {
+    auto& durations = warm[phase.name];
+    std::sort(durations.begin(), durations.end());
+    std::cout << std::left << std::fixed << std::setprecision(3) << std::setw(32) << phase.name
+              << " ; " << std::right << std::setw(10) << Milliseconds(phase.start) << " ; "
+              << std::setw(10) << Milliseconds(phase.duration) << " ; " << std::setw(15)
+              << (durations.empty() ? 0 : durations[durations.size() / 2]) << std::endl;
+  }
+}
@@ -0,0 +1,117 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BaseJsTest.h"
+
+namespace
+{
+  // Roughly the number of filters in EasyList.
+  const int kFilterCount = 70000;
+  const std::string kSubscriptionUrl = "https://example.com/easylist.txt";
+
+  std::string GenerateFilterList(int filterCount)
+  {
+    std::string list = "[Adblock Plus 2.0]\n! Expires: 4 days\n";
+    for (int i = 0; i < filterCount; ++i)
+    {
+      switch (i % 4)
+      {
+      case 0:
+        list += "||ads" + std::to_string(i) + ".example.com^$third-party\n";
+        break;
+      case 1:
+        list += "/banner" + std::to_string(i) + "/*$image\n";
+        break;
+      case 2:
+        list += "example" + std::to_string(i) + ".com##.ad-" + std::to_string(i) + "\n";
+        break;
+      default:
+        list += "@@||cdn" + std::to_string(i) + ".example.net^$script\n";
+        break;
+      }
+    }
+    return list;
+  }
+
+  class GeneratedResourceReader : public AdblockPlus::IResourceReader
+  {
+  public:
+    void ReadPreloadedFilterList(const std::string& url,
+                                 const ReadCallback& doneCallback) const override
+    {
+      doneCallback(std::make_unique<AdblockPlus::StringPreloadedFilterResponse>(
+          url == kSubscriptionUrl ? GenerateFilterList(kFilterCount) : ""));
+    }
+  };
+}
+
+/*
+ * Measures how long Matches() calls are blocked while a large preloaded
+ * subscription is added. Matches are issued back to back from the test
+ * thread until all filters of the subscription are active. The list is
+ * applied by adblockpluscore in one task, so the max latency includes that
+ * task.
+ */
+TEST(SubscriptionUpdateBenchmark, MatchLatencyWhileApplyingList)
+{
+  AdblockPlus::PlatformFactory::CreationParameters params;
+  params.fileSystem.reset(new InMemoryFileSystem());
+  params.resourceReader.reset(new GeneratedResourceReader());
+  auto platform = CreateBenchmarkPlatform(std::move(params));
+  auto& engine = platform->GetFilterEngine();
+
+  auto subscription = engine.GetSubscription(kSubscriptionUrl);
+  auto started = std::chrono::steady_clock::now();
+  engine.AddSubscription(subscription);
+  auto addDuration = std::chrono::steady_clock::now() - started;
+
+  std::vector<double> latencies;
+  const auto timeout = std::chrono::minutes(2);
+  while (std::chrono::steady_clock::now() - started < timeout)
+  {
+    auto matchStarted = std::chrono::steady_clock::now();
+    engine.Matches("http://ads1.example.com/banner.gif",
+                   AdblockPlus::IFilterEngine::CONTENT_TYPE_IMAGE,
+                   "http://example.org/");
+    latencies.push_back(std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - matchStarted)
+                            .count());
+    if (subscription.GetFilterCount() >= kFilterCount)
+      break;
+  }
+  auto totalDuration = std::chrono::steady_clock::now() - started;
+  ASSERT_GE(subscription.GetFilterCount(), kFilterCount);
+  ASSERT_FALSE(latencies.empty());
+
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << std::fixed << std::setprecision(3) << "Filters               : " << kFilterCount
+            << std::endl
+            << "AddSubscription(ms)   : "
+            << std::chrono::duration<double, std::milli>(addDuration).count() << std::endl
+            << "Applied after(ms)     : "
+            << std::chrono::duration<double, std::milli>(totalDuration).count() << std::endl
+            << "Matches               : " << latencies.size() << std::endl
+            << "Median latency(us)    : " << latencies[latencies.size() / 2] << std::endl
+            << "Max latency(us)       : " << latencies.back() << std::endl;
+}
@@ -0,0 +1,200 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BaseJsTest.h"
+
+namespace
+{
+  const std::string kListUrlPrefix = "https://example.com/list";
+  const auto kSimulatedTime = std::chrono::hours(24 * 28);
+  const auto kStep = std::chrono::hours(1);
+
+  struct SubscriptionMix
+  {
+    std::string name;
+    int listCount;
+    int filtersPerList;
+  };
+
+  // Lists expire after 1 to 4 days, so that their downloads interleave.
+  std::string GenerateFilterList(int index, int filterCount)
+  {
+    std::string list = "[Adblock Plus 2.0]\n! Expires: " + std::to_string(index % 4 + 1) +
+                       " days\n";
+    const std::string prefix = std::to_string(index) + "-";
+    for (int i = 0; i < filterCount; ++i)
+    {
+      switch (i % 3)
+      {
+      case 0:
+        list += "||ads" + prefix + std::to_string(i) + ".example.com^$third-party\n";
+        break;
+      case 1:
+        list += "/banner" + prefix + std::to_string(i) + "/*$image\n";
+        break;
+      default:
+        list += "example" + prefix + std::to_string(i) + ".com##.ad\n";
+        break;
+      }
+    }
+    return list;
+  }
+
+  class CountingFileSystem : public InMemoryFileSystem
+  {
+  public:
+    CountingFileSystem() : bytesWritten(0)
+    {
+    }
+
+    void Write(const std::string& fileName, const IOBuffer& data, const Callback& callback) override
+    {
+      bytesWritten += data.size();
+      InMemoryFileSystem::Write(fileName, data, callback);
+    }
+
+    size_t bytesWritten;
+  };
+
+  struct Cost
+  {
+    Cost() : count(0), cpuMs(0), bytesWritten(0), bytesDownloaded(0)
+    {
+    }
+
+    int count;
+    double cpuMs;
+    size_t bytesWritten;
+    size_t bytesDownloaded;
+  };
+
+  double CpuMs(std::clock_t started)
+  {
+    return 1000.0 * (std::clock() - started) / CLOCKS_PER_SEC;
+  }
+
+  void PrintCost(const std::string& name, const Cost& cost)
+  {
+    const int count = std::max(cost.count, 1);
+    std::cout << "  " << std::left << std::setw(14) << name << std::right << std::setw(6)
+              << cost.count << std::setw(14) << cost.cpuMs / count << std::setw(14)
+              << cost.bytesWritten / 1024.0 / count << std::setw(14)
+              << cost.bytesDownloaded / 1024.0 / count << std::endl;
+  }
+}
+
+/*
+ * Simulates four weeks of synchronization on a virtual clock, advancing it an
+ * hour at a time. An hour in which at least one list is downloaded is a sync
+ * cycle, the other hours are idle checks. CPU time is process CPU time, so it
+ * includes V8's helper threads. Bytes written are the ones passed to the
+ * file system, the in-memory file system rewrites files on append.
+ */
+TEST(SynchronizerBenchmark, CostPerSyncCycle)
+{
+  const std::vector<SubscriptionMix> mixes = {
+      {"1 x 50000", 1, 50000}, {"3 x 20000", 3, 20000}, {"10 x 5000", 10, 5000}};
+
+  for (const auto& mix : mixes)
+  {
+    FixtureWebRequest::Fixtures fixtures;
+    for (int i = 0; i < mix.listCount; ++i)
+      fixtures[kListUrlPrefix + std::to_string(i)] = GenerateFilterList(i, mix.filtersPerList);
+
+    VirtualTimer::SharedClock clock;
+    CountingFileSystem* fileSystem;
+    FixtureWebRequest* webRequest;
+    AdblockPlus::PlatformFactory::CreationParameters params;
+    params.logSystem.reset(new LazyLogSystem());
+    params.timer = VirtualTimer::New(clock);
+    params.fileSystem.reset(fileSystem = new CountingFileSystem());
+    params.webRequest.reset(
+        webRequest = new FixtureWebRequest(fixtures, [&clock](const FixtureWebRequest::Task& task) {
+          clock->Schedule(std::chrono::milliseconds::zero(), task);
+        }));
+    auto platform = AdblockPlus::PlatformFactory::CreatePlatform(std::move(params));
+    clock->InstallInJsEngine(
+        static_cast<AdblockPlus::DefaultPlatform*>(platform.get())->GetJsEngine());
+
+    auto engineParams = BenchmarkEngineParameters();
+    engineParams.preconfiguredPrefs.booleanPrefs
+        [AdblockPlus::FilterEngineFactory::BooleanPrefName::SynchronizationEnabled] = true;
+    auto& engine = CreateFilterEngine(*platform, *clock, engineParams);
+
+    auto wallStarted = std::chrono::steady_clock::now();
+    Cost cycles;
+    Cost idle;
+    int downloads = 0;
+    auto measure = [&](const std::function<void()>& step) {
+      const size_t requestCount = webRequest->requestCount;
+      const size_t responseBytes = webRequest->responseBytes;
+      const size_t bytesWritten = fileSystem->bytesWritten;
+      const auto cpuStarted = std::clock();
+      step();
+      Cost cost;
+      cost.count = 1;
+      cost.cpuMs = CpuMs(cpuStarted);
+      cost.bytesWritten = fileSystem->bytesWritten - bytesWritten;
+      cost.bytesDownloaded = webRequest->responseBytes - responseBytes;
+      downloads += webRequest->requestCount - requestCount;
+      return std::make_pair(cost, webRequest->requestCount > requestCount);
+    };
+    auto add = [](Cost& total, const Cost& cost) {
+      total.count += cost.count;
+      total.cpuMs += cost.cpuMs;
+      total.bytesWritten += cost.bytesWritten;
+      total.bytesDownloaded += cost.bytesDownloaded;
+    };
+
+    const Cost initial = measure([&]() {
+      for (int i = 0; i < mix.listCount; ++i)
+        engine.AddSubscription(engine.GetSubscription(kListUrlPrefix + std::to_string(i)));
+      clock->RunPending();
+    }).first;
+    for (auto elapsed = kStep; elapsed <= kSimulatedTime; elapsed += kStep)
+    {
+      auto result = measure([&]() { clock->Advance(kStep); });
+      add(result.second ? cycles : idle, result.first);
+    }
+    const auto wallDuration = std::chrono::steady_clock::now() - wallStarted;
+
+    for (const auto& subscription : engine.GetListedSubscriptions())
+      EXPECT_EQ(mix.filtersPerList, subscription.GetFilterCount()) << subscription.GetUrl();
+    EXPECT_LT(mix.listCount, downloads);
+
+    std::cout << std::fixed << std::setprecision(2) << mix.name << " filters, "
+              << downloads << " downloads in "
+              << std::chrono::duration_cast<std::chrono::hours>(kSimulatedTime).count() / 24
+              << " days simulated in "
+              << std::chrono::duration<double>(wallDuration).count() << " s" << std::endl
+              << "  " << std::left << std::setw(14) << "" << std::right << std::setw(6)
+              << "count" << std::setw(14) << "cpu ms" << std::setw(14) << "written KiB"
+              << std::setw(14) << "download KiB" << std::endl;
+    PrintCost("initial", initial);
+    PrintCost("sync cycle", cycles);
+    PrintCost("idle check", idle);
+  }
+}
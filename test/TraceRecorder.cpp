@@ -0,0 +1,68 @@
+/*
+ * This file is part of Adblock Plus <https://adblockplus.org/>,
+ * Copyright (C) 2006-present eyeo GmbH
+ *
+ * Adblock Plus is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * Adblock Plus is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Adblock Plus. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../src/TraceRecorder.h"
+
+#include <gtest/gtest.h>
+
+using namespace AdblockPlus;
+
+namespace
+{
+  std::string RecordCall(const std::string& url)
+  {
+    std::string line = TraceRecorder::Line("matches")
+                           .AddString("url", url)
+                           .Finish(std::chrono::steady_clock::now());
+    // The latency varies, it's the last field.
+    return line.substr(0, line.rfind(",\"_us\":"));
+  }
+}
+
+TEST(TraceRecorderTest, FormatsJsonLines)
+{
+  std::string line = TraceRecorder::Line("check")
+                         .AddString("url", "http://example.com/\"a\\b\"\n")
+                         .AddList("referrers", {"x", "y"})
+                         .AddInt("type", 4)
+                         .AddBool("_res", true)
+                         .Finish(std::chrono::steady_clock::now());
+  const std::string expected =
+      "{\"_fn\":\"check\",\"url\":\"http://example.com/\\\"a\\\\b\\\"\\u000a\","
+      "\"referrers\":[\"x\",\"y\"],\"type\":4,\"_res\":true,\"_us\":";
+  EXPECT_EQ(expected, line.substr(0, expected.size()));
+  EXPECT_EQ('}', line.back());
+}
+
+TEST(TraceRecorderTest, KeepsMostRecentCalls)
+{
+  TraceRecorder recorder;
+  recorder.Record(RecordCall("ignored"));
+  EXPECT_EQ("", recorder.Take());
+
+  recorder.Start(2);
+  recorder.Record(RecordCall("a"));
+  recorder.Record(RecordCall("b"));
+  recorder.Record(RecordCall("c"));
+  EXPECT_EQ(RecordCall("b") + "\n" + RecordCall("c") + "\n", recorder.Take());
+  EXPECT_EQ("", recorder.Take());
+
+  recorder.Record(RecordCall("d"));
+  recorder.Stop();
+  recorder.Record(RecordCall("e"));
+  EXPECT_EQ(RecordCall("d") + "\n", recorder.Take());
+}
@@ -37,4 +37,50 @@ TEST(UtilsTest, SplitString)
   ASSERT_EQ("c", res[4]);
   ASSERT_EQ("d", res[5]);
   ASSERT_EQ("", res[6]);
-}
\ No newline at end of file
+}
+
+TEST(UtilsTest, IsAscii)
+{
+  EXPECT_TRUE(Utils::IsAscii("", 0));
+  std::string text(200, 'a');
+  EXPECT_TRUE(Utils::IsAscii(text.data(), text.size()));
+  // Check every position to cover the vectorized, word and byte loops.
+  for (size_t i = 0; i < text.size(); ++i)
+  {
+    std::string modified = text;
+    modified[i] = '\xC3';
+    EXPECT_FALSE(Utils::IsAscii(modified.data(), modified.size())) << "position " << i;
+    EXPECT_TRUE(Utils::IsAscii(modified.data(), i)) << "position " << i;
+  }
+}
+
+TEST(UtilsTest, FindLineBreak)
+{
+  std::string text(100, 'a');
+  const char* end = text.data() + text.size();
+  bool isAscii = true;
+  EXPECT_EQ(end, Utils::FindLineBreak(text.data(), end, &isAscii));
+  EXPECT_TRUE(isAscii);
+
+  // Check every position to cover the vectorized and byte loops.
+  for (size_t i = 0; i < text.size(); ++i)
+  {
+    std::string modified = text;
+    modified[i] = i % 2 ? '\n' : '\r';
+    const char* begin = modified.data();
+    EXPECT_EQ(begin + i, Utils::FindLineBreak(begin, begin + modified.size())) << "position " << i;
+
+    modified[i] = ',';
+    EXPECT_EQ(begin + i, Utils::FindDelimiter(begin, begin + modified.size(), ','))
+        << "position " << i;
+
+    // Only bytes before the delimiter count.
+    if (i + 1 < modified.size())
+      modified.back() = '\xC3';
+    if (i > 0)
+      modified[i - 1] = '\xC3';
+    isAscii = true;
+    Utils::FindDelimiter(begin, begin + modified.size(), ',', &isAscii);
+    EXPECT_EQ(i == 0, isAscii) << "position " << i;
+  }
+}
@@ -4,6 +4,7 @@
     'type': 'executable',
     'xcode_settings': {},
     'dependencies': [
+      'abpshell.gyp:traceworkload',
       'googletest.gyp:googletest_main',
       'libadblockplus.gyp:libadblockplus'
     ],
@@ -15,17 +16,22 @@
       'test/BaseJsTest.h',
       'test/BaseJsTest.cpp',
       'test/AppInfoJsObject.cpp',
+      'test/CompressingFileSystem.cpp',
       'test/ConsoleJsObject.cpp',
       'test/DefaultFileSystem.cpp',
       'test/FileSystemJsObject.cpp',
       'test/FilterEngineTest.h',
       'test/FilterEngine.cpp',
+      'test/FilterListPreparser.cpp',
       'test/GlobalJsObject.cpp',
       'test/HarnessTest.cpp',
+      'test/IO.cpp',
       'test/JsEngine.cpp',
       'test/JsValue.cpp',
       'test/PreloadedSubscriptions.cpp',
       'test/ReferrerMapping.cpp',
+      'test/SignatureVerifier.cpp',
+      'test/TraceRecorder.cpp',
       'test/Utils.cpp',
       'test/WebRequest.cpp'
     ],
@@ -35,5 +41,59 @@
         'EntryPointSymbol': 'mainCRTStartup',
       },
     },
+  },
+  {
+    'target_name': 'benchmarks',
+    'type': 'executable',
+    'xcode_settings': {},
+    'dependencies': [
+      'abpshell.gyp:traceworkload',
+      'googletest.gyp:googletest_main',
+      'libadblockplus.gyp:libadblockplus'
+    ],
+    'include_dirs': [
+      '<(libv8_include_dir)'
+    ],
+    'sources': [
+      'test/BaseJsTest.h',
+      'test/BaseJsTest.cpp',
+      'test/ContentionBenchmark.cpp',
+      'test/LineScannerBenchmark.cpp',
+      'test/MemoryBenchmark.cpp',
+      'test/StartupBenchmark.cpp',
+      'test/SubscriptionUpdateBenchmark.cpp',
+      'test/SynchronizerBenchmark.cpp'
+    ],
+    'msvs_settings': {
+      'VCLinkerTool': {
+        'SubSystem': '1',   # Console
+        'EntryPointSymbol': 'mainCRTStartup',
+      },
+    },
+  },
+  {
+    # Replaces the global operator new to count allocations, so it is built
+    # on its own and doesn't slow down the other benchmarks.
+    'target_name': 'bridge_benchmarks',
+    'type': 'executable',
+    'xcode_settings': {},
+    'dependencies': [
+      'googletest.gyp:googletest_main',
+      'libadblockplus.gyp:libadblockplus'
+    ],
+    'include_dirs': [
+      '<(libv8_include_dir)'
+    ],
+    'sources': [
+      'test/BaseJsTest.h',
+      'test/BaseJsTest.cpp',
+      'test/BridgeBenchmark.cpp'
+    ],
+    'msvs_settings': {
+      'VCLinkerTool': {
+        'SubSystem': '1',   # Console
+        'EntryPointSymbol': 'mainCRTStartup',
+      },
+    },
   }]
 }